@@ -0,0 +1,109 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Measures downsampling of one week of 1 Hz history of several numeric topics into buckets of
+ * different widths, compared to decoding all samples.
+ *
+ * usage: bench_aggregate [topics]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "flunder/aggregate.h"
+#include "flunder/history.h"
+
+namespace {
+
+constexpr auto MIN_TS = std::numeric_limits<std::int64_t>::min();
+constexpr auto MAX_TS = std::numeric_limits<std::int64_t>::max();
+
+auto run(
+    const char* name,
+    const flunder::history_t& history,
+    const std::vector<std::string>& topics,
+    std::chrono::nanoseconds width) //
+    -> void
+{
+    auto buckets = std::size_t{};
+    auto aggregator = flunder::aggregator_t{width};
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& topic : topics) {
+        history.aggregate(topic, MIN_TS, MAX_TS, aggregator);
+        buckets += aggregator.take().size();
+    }
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    std::printf(
+        "%-10s %10zu buckets  %9.2f ms\n",
+        name,
+        buckets,
+        std::chrono::duration<double, std::milli>(time).count());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100;
+
+    constexpr auto duration = std::chrono::days{7};
+    const auto samples = static_cast<std::size_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(duration).count());
+    const auto period = std::int64_t{1'000'000'000};
+    const auto start_ts = std::int64_t{1'700'000'000'000'000'000};
+
+    auto history = flunder::history_t{duration};
+    auto topics = std::vector<std::string>{};
+    for (auto t = std::size_t{}; t < count; ++t) {
+        topics.push_back("flecs/flunder/bench/aggregate/" + std::to_string(t));
+    }
+    for (auto i = std::size_t{}; i < samples; ++i) {
+        for (auto t = std::size_t{}; t < count; ++t) {
+            const auto value = std::round((20.0 + 5.0 * std::sin(i * 1e-4 + t)) * 10.0) / 10.0;
+            const auto ts = start_ts + static_cast<std::int64_t>(i) * period;
+            history.append(topics[t], flunder::sample_t{ts, value});
+        }
+    }
+    std::printf(
+        "%lu topics at 1 Hz, 7 d of history, %.1f MiB\n",
+        count,
+        static_cast<double>(history.memory_usage()) / (1024.0 * 1024.0));
+
+    auto decoded = std::size_t{};
+    const auto decode_start = std::chrono::steady_clock::now();
+    for (const auto& topic : topics) {
+        history.scan(topic, MIN_TS, MAX_TS, [&decoded](std::span<const flunder::sample_t> block) {
+            decoded += block.size();
+        });
+    }
+    const auto decode_time = std::chrono::steady_clock::now() - decode_start;
+    std::printf(
+        "%-10s %10zu samples  %9.2f ms\n",
+        "decode",
+        decoded,
+        std::chrono::duration<double, std::milli>(decode_time).count());
+
+    run("1 min", history, topics, std::chrono::minutes{1});
+    run("1 h", history, topics, std::chrono::hours{1});
+    run("1 d", history, topics, std::chrono::days{1});
+
+    return 0;
+}
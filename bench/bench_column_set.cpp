@@ -0,0 +1,131 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Compares collecting numeric query replies as get() does and converting them one variable at a
+ * time, with atof as consumers do and with variable_t::try_as, against decoding them into a
+ * column_set_t as get_columns() does. Replies are synthesized, so no router is needed.
+ *
+ * usage: bench_column_set [variables]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "flunder/column_set.h"
+
+namespace {
+
+struct reply_t
+{
+    std::string topic;
+    std::string value;
+    std::string encoding;
+    std::string timestamp;
+};
+
+template <typename Collect>
+auto run(const char* name, const std::vector<reply_t>& replies, Collect&& collect) //
+    -> void
+{
+    const auto start = std::chrono::steady_clock::now();
+    /* summed up so the conversions cannot be optimized away */
+    const auto sum = collect(replies);
+    const auto time = std::chrono::duration<double, std::nano>{
+        std::chrono::steady_clock::now() - start};
+
+    std::printf(
+        "%-16s %8.1f ns/value  (sum %g)\n",
+        name,
+        time.count() / static_cast<double>(replies.size()),
+        sum);
+}
+
+/* a reply as handed out by the receive path, viewing its buffers */
+auto view(const reply_t& reply) //
+    -> flunder::variable_t
+{
+    return flunder::variable_t{
+        std::string_view{reply.topic},
+        std::string_view{reply.value},
+        std::string_view{reply.encoding},
+        std::string_view{reply.timestamp}};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1'000'000ULL;
+
+    /* half integers, half decimals */
+    auto replies = std::vector<reply_t>{};
+    replies.reserve(n);
+    for (auto i = std::size_t{}; i < n; ++i) {
+        auto reply = reply_t{
+            "flecs/flunder/bench/column_set/" + std::to_string(i % 1000),
+            {},
+            {},
+            std::to_string(1'700'000'000'000'000'000ULL + i)};
+        if (i % 2) {
+            reply.value = std::to_string(i * 7919);
+            reply.encoding = "text/plain;int64";
+        } else {
+            reply.value = std::to_string(static_cast<double>(i) / 64.0);
+            reply.value.erase(reply.value.find_last_not_of('0') + 1);
+            reply.encoding = "text/plain;float64";
+        }
+        replies.push_back(std::move(reply));
+    }
+
+    run("get + atof", replies, [](const std::vector<reply_t>& replies) {
+        auto vars = std::vector<flunder::variable_t>{};
+        for (const auto& reply : replies) {
+            vars.emplace_back(view(reply)).own();
+        }
+        auto sum = 0.0;
+        for (const auto& var : vars) {
+            sum += std::atof(var.value().data());
+        }
+        return sum;
+    });
+    run("get + try_as", replies, [](const std::vector<reply_t>& replies) {
+        auto vars = std::vector<flunder::variable_t>{};
+        for (const auto& reply : replies) {
+            vars.emplace_back(view(reply)).own();
+        }
+        auto sum = 0.0;
+        for (const auto& var : vars) {
+            sum += std::get<1>(var.try_as<double>());
+        }
+        return sum;
+    });
+    run("get_columns", replies, [](const std::vector<reply_t>& replies) {
+        auto columns = flunder::column_set_t{};
+        for (const auto& reply : replies) {
+            columns.push_back(view(reply));
+        }
+        auto sum = 0.0;
+        for (const auto value : columns.values()) {
+            sum += value;
+        }
+        return sum;
+    });
+
+    return 0;
+}
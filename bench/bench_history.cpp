@@ -0,0 +1,104 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Measures memory per sample and decode throughput of history_t for one hour of samples of
+ * several numeric topics, with regular and jittered timestamps.
+ *
+ * usage: bench_history [topics] [rate_hz]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "flunder/history.h"
+
+namespace {
+
+/* timestamps deviate from the sampling period by up to jitter * period */
+auto run(const char* name, std::size_t topics, std::size_t rate, double jitter) //
+    -> void
+{
+    constexpr auto duration = std::chrono::hours{1};
+    const auto samples = static_cast<std::size_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(duration).count() * rate);
+    const auto period = std::int64_t{1'000'000'000} / static_cast<std::int64_t>(rate);
+
+    auto history = flunder::history_t{duration};
+    auto rng = std::mt19937_64{42};
+    const auto jitter_ns = static_cast<std::int64_t>(jitter * static_cast<double>(period));
+    auto deviation = std::uniform_int_distribution<std::int64_t>{-jitter_ns, jitter_ns};
+    auto noise = std::normal_distribution<double>{0.0, 0.05};
+
+    const auto start_ts = std::int64_t{1'700'000'000'000'000'000};
+    auto names = std::vector<std::string>{};
+    for (auto t = std::size_t{}; t < topics; ++t) {
+        names.push_back("flecs/flunder/bench/history/" + std::to_string(t));
+    }
+
+    const auto append_start = std::chrono::steady_clock::now();
+    for (auto i = std::size_t{}; i < samples; ++i) {
+        for (auto t = std::size_t{}; t < topics; ++t) {
+            /* slowly changing sensor value, quantized to 0.1 like typical temperature readings */
+            const auto value =
+                std::round((20.0 + 5.0 * std::sin(i * 1e-4 + t) + noise(rng)) * 10.0) / 10.0;
+            const auto ts = start_ts + static_cast<std::int64_t>(i) * period + deviation(rng);
+            history.append(names[t], flunder::sample_t{ts, value});
+        }
+    }
+    const auto append_time = std::chrono::steady_clock::now() - append_start;
+
+    auto decoded = std::size_t{};
+    const auto decode_start = std::chrono::steady_clock::now();
+    for (const auto& topic : names) {
+        history.scan(
+            topic,
+            std::numeric_limits<std::int64_t>::min(),
+            std::numeric_limits<std::int64_t>::max(),
+            [&decoded](std::span<const flunder::sample_t> block) { decoded += block.size(); });
+    }
+    const auto decode_time = std::chrono::steady_clock::now() - decode_start;
+
+    const auto total = static_cast<double>(samples * topics);
+    std::printf(
+        "%-10s %10.0f samples  %6.2f bytes/sample  append %7.1f Msamples/s  decode %7.1f "
+        "Msamples/s\n",
+        name,
+        total,
+        static_cast<double>(history.memory_usage()) / total,
+        total / std::chrono::duration<double, std::micro>(append_time).count(),
+        static_cast<double>(decoded) /
+            std::chrono::duration<double, std::micro>(decode_time).count());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto topics = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10;
+    const auto rate = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 100;
+
+    std::printf("%lu topics at %lu Hz, 1 h of history\n", topics, rate);
+    run("regular", topics, rate, 0.0);
+    run("jitter 0.1%", topics, rate, 0.001);
+    run("jitter 10%", topics, rate, 0.1);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Compares payload size, encode and decode time of a configuration document of about 50 KB as
+ * JSON text, CBOR and MessagePack. No router is needed.
+ *
+ * usage: bench_json [iterations]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "flunder/json.h"
+
+namespace {
+
+/* a device configuration of the size we publish: apps with ports, environment and limits */
+auto make_config(std::size_t min_size) //
+    -> nlohmann::json
+{
+    auto config = nlohmann::json{
+        {"version", "4.0.0"},
+        {"device", {{"id", "b1c5b4ef-54e1-4b3e-9d6a-1c0a9c1ad2f3"}, {"name", "edge-gateway"}}},
+        {"apps", nlohmann::json::array()},
+    };
+    for (auto i = 0; config.dump().size() < min_size; ++i) {
+        auto app = nlohmann::json{
+            {"name", "tech.flecs.app-" + std::to_string(i)},
+            {"version", "1." + std::to_string(i % 10) + ".0"},
+            {"enabled", i % 3 != 0},
+            {"ports", {8000 + i, 9000 + i, 10000 + i}},
+            {"env", {{"LOG_LEVEL", "info"}, {"SAMPLE_RATE", 100 * (i + 1)}}},
+            {"limits", {{"cpu", 0.25 * (i % 4 + 1)}, {"memory", 64 * 1024 * 1024 * (i % 8 + 1)}}},
+            {"calibration", {1.0125, -0.5, 3.75, 12.0625, 0.001, 42.0}},
+        };
+        config["apps"].push_back(std::move(app));
+    }
+    return config;
+}
+
+auto serialize(const nlohmann::json& doc, flunder::json_format_t format) //
+    -> std::string
+{
+    switch (format) {
+        case flunder::json_format_t::cbor: {
+            const auto bytes = nlohmann::json::to_cbor(doc);
+            return std::string{bytes.begin(), bytes.end()};
+        }
+        case flunder::json_format_t::msgpack: {
+            const auto bytes = nlohmann::json::to_msgpack(doc);
+            return std::string{bytes.begin(), bytes.end()};
+        }
+        case flunder::json_format_t::text:
+        default:
+            return doc.dump();
+    }
+}
+
+template <typename F>
+auto time_per_call(std::size_t n, F&& f) //
+    -> double
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = std::size_t{}; i < n; ++i) {
+        f();
+    }
+    const auto time = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(time).count() / static_cast<double>(n);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 200ULL;
+
+    const auto config = make_config(50 * 1024);
+    const auto formats = {
+        std::pair{"text", flunder::json_format_t::text},
+        std::pair{"cbor", flunder::json_format_t::cbor},
+        std::pair{"msgpack", flunder::json_format_t::msgpack},
+    };
+
+    std::printf("%-8s %10s %12s %12s\n", "format", "bytes", "encode", "decode");
+    for (const auto& [name, format] : formats) {
+        const auto payload = serialize(config, format);
+        const auto encode = time_per_call(n, [&config, format]() { serialize(config, format); });
+        const auto var = flunder::variable_t{
+            std::string_view{"flecs/flunder/bench/json"},
+            std::string_view{payload},
+            flunder::json_encoding(format),
+            std::string_view{}};
+        auto ok = true;
+        const auto decode = time_per_call(n, [&var, &ok]() {
+            ok &= (flunder::as_json(var).get() != nullptr);
+        });
+        std::printf(
+            "%-8s %10zu %9.1f us %9.1f us%s\n",
+            name,
+            payload.size(),
+            encode,
+            decode,
+            ok ? "" : "  (decoding failed)");
+    }
+
+    return 0;
+}
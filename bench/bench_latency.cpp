@@ -0,0 +1,122 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Measures the round-trip latency of small samples between two co-located clients, through a
+ * router over tcp and unix sockets and over direct peer links without a router.
+ *
+ * Client modes spawn zenohd, which has to be in PATH; otherwise they are skipped.
+ *
+ * usage: bench_latency [round trips]
+ */
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "flunder/client.h"
+#include "round_trip.h"
+
+extern char** environ;
+
+namespace {
+
+constexpr auto PING = "flecs/flunder/bench/latency/ping";
+constexpr auto PONG = "flecs/flunder/bench/latency/pong";
+
+auto start_router(const char* tcp, const char* unixsock) //
+    -> pid_t
+{
+    auto pid = pid_t{};
+    char* argv[] = {
+        const_cast<char*>("zenohd"),
+        const_cast<char*>("--no-multicast-scouting"),
+        const_cast<char*>("-l"),
+        const_cast<char*>(tcp),
+        const_cast<char*>("-l"),
+        const_cast<char*>(unixsock),
+        nullptr};
+    if (posix_spawnp(&pid, "zenohd", nullptr, nullptr, argv, environ) != 0) {
+        return -1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    return pid;
+}
+
+auto run(
+    const char* name,
+    const flunder::connect_options_t& ping_options,
+    const flunder::connect_options_t& pong_options,
+    std::size_t n) //
+    -> void
+{
+    auto pinger = flunder::client_t{};
+    auto ponger = flunder::client_t{};
+    if (ponger.connect(pong_options) != 0 || pinger.connect(ping_options) != 0) {
+        std::printf("%-16s could not connect\n", name);
+        return;
+    }
+
+    const auto rtts = bench::round_trips(pinger, ponger, PING, PONG, n);
+    std::printf(
+        "%-16s p50 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+        name,
+        bench::percentile_us(rtts, 50),
+        bench::percentile_us(rtts, 99),
+        bench::percentile_us(rtts, 100));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 10'000ULL;
+
+    constexpr auto router_tcp = "tcp/127.0.0.1:7460";
+    constexpr auto router_unixsock = "unixsock-stream//tmp/flunder-bench-router.sock";
+    constexpr auto peer_tcp = "tcp/127.0.0.1:7461";
+    constexpr auto peer_unixsock = "unixsock-stream//tmp/flunder-bench-peer.sock";
+
+    const auto router = start_router(router_tcp, router_unixsock);
+    if (router != -1) {
+        auto options = flunder::connect_options_t{};
+        options.endpoints = {router_tcp};
+        run("client tcp", options, options, n);
+        options.endpoints = {router_unixsock};
+        run("client unixsock", options, options, n);
+        kill(router, SIGTERM);
+        waitpid(router, nullptr, 0);
+    } else {
+        std::printf("zenohd not found, skipping client modes\n");
+    }
+
+    for (const auto endpoint : {peer_tcp, peer_unixsock}) {
+        auto pong_options = flunder::connect_options_t{};
+        pong_options.mode = flunder::session_mode_t::peer;
+        pong_options.listen = {endpoint};
+        auto ping_options = flunder::connect_options_t{};
+        ping_options.mode = flunder::session_mode_t::peer;
+        ping_options.endpoints = {endpoint};
+        run((endpoint == peer_tcp) ? "peer tcp" : "peer unixsock", ping_options, pong_options, n);
+    }
+    unlink("/tmp/flunder-bench-router.sock");
+    unlink("/tmp/flunder-bench-peer.sock");
+
+    return 0;
+}
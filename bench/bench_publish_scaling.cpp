@@ -0,0 +1,85 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Measures the aggregate publish rate of 1 to 16 threads sharing one client, with a single session
+ * and with one session per thread.
+ *
+ * usage: bench_publish_scaling [host] [port] [samples per thread]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flunder/client.h"
+
+namespace {
+
+auto run(const flunder::client_t& client, std::size_t threads, std::size_t n) //
+    -> double
+{
+    auto workers = std::vector<std::thread>{};
+    const auto start = std::chrono::steady_clock::now();
+    for (auto t = std::size_t{}; t < threads; ++t) {
+        workers.emplace_back([&client, t, n]() {
+            const auto topic = "flecs/flunder/bench/publish_scaling/" + std::to_string(t);
+            for (auto i = std::uint64_t{}; i < n; ++i) {
+                client.publish(topic, &i, sizeof(i));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    return static_cast<double>(threads * n) / std::chrono::duration<double>(time).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto host = std::string{(argc > 1) ? argv[1] : flunder::FLUNDER_HOST};
+    const auto port = (argc > 2) ? std::atoi(argv[2]) : flunder::FLUNDER_PORT;
+    const auto n = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 100'000ULL;
+
+    auto options = flunder::connect_options_t{};
+    options.endpoints = {"tcp/" + host + ":" + std::to_string(port)};
+
+    std::printf("%8s %16s %16s\n", "threads", "1 session", "sharded");
+    for (const auto threads : {1, 2, 4, 8, 16}) {
+        auto single = flunder::client_t{};
+        options.shards = 1;
+        auto sharded = flunder::client_t{};
+        if (single.connect(options) != 0) {
+            std::fprintf(stderr, "Could not connect to %s:%d\n", host.c_str(), port);
+            return 1;
+        }
+        options.shards = threads;
+        if (sharded.connect(options) != 0) {
+            std::fprintf(stderr, "Could not connect to %s:%d\n", host.c_str(), port);
+            return 1;
+        }
+
+        const auto single_rate = run(single, threads, n);
+        const auto sharded_rate = run(sharded, threads, n);
+        std::printf("%8d %12.0f/s %12.0f/s\n", threads, single_rate, sharded_rate);
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Compares memory and allocations of collecting query replies into a vector of owned variables,
+ * as get() does, additionally moving them into an array, as flunder_get() does, and into a
+ * result_set_t, as get_result_set() and flunder_get_result_set() do. Replies are synthesized, so
+ * no router is needed.
+ *
+ * usage: bench_result_set [variables]
+ */
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flunder/result_set.h"
+
+namespace {
+
+std::size_t g_allocations = 0;
+/* bytes currently allocated, including the overhead of malloc */
+std::size_t g_bytes = 0;
+
+template <typename Collect>
+auto run(const char* name, std::size_t n, Collect&& collect) //
+    -> void
+{
+    auto topic = std::string{};
+    const auto value = std::string{"21.5"};
+    const auto encoding = std::string{"text/plain;float64"};
+    const auto timestamp = std::string{"1700000000000000000"};
+
+    auto allocations = std::size_t{};
+    auto bytes = std::ptrdiff_t{};
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = std::size_t{}; i < n; ++i) {
+        topic = "flecs/flunder/bench/result_set/" + std::to_string(i);
+        const auto var = flunder::variable_t{
+            std::string_view{topic},
+            std::string_view{value},
+            std::string_view{encoding},
+            std::string_view{timestamp}};
+        /* only count what collecting the reply allocates */
+        const auto allocations_before = g_allocations;
+        const auto bytes_before = g_bytes;
+        collect(var);
+        allocations += g_allocations - allocations_before;
+        bytes += static_cast<std::ptrdiff_t>(g_bytes) - static_cast<std::ptrdiff_t>(bytes_before);
+    }
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    std::printf(
+        "%-12s %10zu allocations %9.1f MiB retained %8.1f ms\n",
+        name,
+        allocations,
+        static_cast<double>(bytes) / (1024.0 * 1024.0),
+        std::chrono::duration<double, std::milli>(time).count());
+}
+
+} // namespace
+
+void* operator new(std::size_t n)
+{
+    if (auto p = std::malloc(n ? n : 1)) {
+        ++g_allocations;
+        g_bytes += malloc_usable_size(p);
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p) {
+        g_bytes -= malloc_usable_size(p);
+    }
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+int main(int argc, char** argv)
+{
+    const auto n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1'000'000ULL;
+
+    std::printf("sizeof(variable_t) = %zu\n", sizeof(flunder::variable_t));
+    {
+        auto vars = std::vector<flunder::variable_t>{};
+        run("vector", n, [&vars](const flunder::variable_t& var) {
+            vars.emplace_back(var);
+        });
+    }
+    {
+        auto vars = std::vector<flunder::variable_t>{};
+        auto* list = static_cast<flunder::variable_t*>(nullptr);
+        auto count = std::size_t{};
+        run("c list", n, [&vars, &list, &count, n](const flunder::variable_t& var) {
+            vars.emplace_back(var);
+            if (vars.size() == n) {
+                count = vars.size();
+                list = new flunder::variable_t[count];
+                std::move(vars.begin(), vars.end(), list);
+                vars = {};
+            }
+        });
+        flunder_variable_list_destroy(list, count);
+    }
+    {
+        auto results = flunder::result_set_t{};
+        run("result_set", n, [&results](const flunder::variable_t& var) {
+            results.push_back(var);
+        });
+    }
+
+    return 0;
+}
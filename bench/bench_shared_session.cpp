@@ -0,0 +1,104 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Reports resident memory and thread count of a process connecting 1 and many clients, with a
+ * session per client and with one shared session. Every scenario runs in a process of its own.
+ *
+ * usage: bench_shared_session [host] [port] [clients]
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flunder/client.h"
+
+namespace {
+
+/* returns the value of field in /proc/self/status, e.g. VmRSS in kB */
+auto proc_status(const char* field) //
+    -> long
+{
+    auto* file = std::fopen("/proc/self/status", "r");
+    if (!file) {
+        return -1;
+    }
+    auto value = -1L;
+    char line[256];
+    const auto len = std::strlen(field);
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, field, len) == 0 && line[len] == ':') {
+            value = std::strtol(line + len + 1, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+
+auto run(const flunder::connect_options_t& options, std::size_t count) //
+    -> void
+{
+    auto clients = std::vector<flunder::client_t>(count);
+    for (auto& client : clients) {
+        if (client.connect(options) != 0) {
+            std::printf("could not connect\n");
+            return;
+        }
+        client.subscribe(
+            "flecs/flunder/bench/shared_session",
+            [](flunder::client_t*, const flunder::variable_t*) {});
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+
+    std::printf(
+        "%-8s %4zu clients  %8ld kB rss  %4ld threads\n",
+        options.shared_session ? "shared" : "separate",
+        count,
+        proc_status("VmRSS"),
+        proc_status("Threads"));
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto host = std::string{(argc > 1) ? argv[1] : flunder::FLUNDER_HOST};
+    const auto port = (argc > 2) ? std::atoi(argv[2]) : flunder::FLUNDER_PORT;
+    const auto count = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 20ULL;
+
+    auto options = flunder::connect_options_t{};
+    options.endpoints = {"tcp/" + host + ":" + std::to_string(port)};
+    for (const auto shared : {false, true}) {
+        for (const auto n : {std::size_t{1}, static_cast<std::size_t>(count)}) {
+            options.shared_session = shared;
+            const auto pid = fork();
+            if (pid == 0) {
+                run(options, n);
+                std::_Exit(0);
+            }
+            waitpid(pid, nullptr, 0);
+        }
+    }
+
+    return 0;
+}
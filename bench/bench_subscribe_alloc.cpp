@@ -0,0 +1,125 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Counts the allocations through operator new while samples are dispatched to a subscription,
+ * after the receive buffers of the subscription have been warmed up. Allocations of the main
+ * thread, which publishes, are not counted. Exits with 1 if dispatching allocated.
+ *
+ * usage: bench_subscribe_alloc [host] [port] [samples]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "flunder/client.h"
+
+namespace {
+
+constexpr auto TOPIC = "flecs/flunder/bench/subscribe_alloc";
+constexpr auto PAYLOAD = "Hello, FLECS!";
+constexpr auto PAYLOAD_LEN = std::size_t{13};
+
+auto g_count_allocations = std::atomic<bool>{};
+auto g_allocations = std::atomic<std::size_t>{};
+thread_local auto t_main_thread = false;
+
+auto publish(flunder::client_t& client, const std::atomic<std::size_t>& received, std::size_t n) //
+    -> bool
+{
+    const auto target = received.load(std::memory_order_acquire) + n;
+    for (std::size_t i = 0; i < n; ++i) {
+        client.publish(TOPIC, PAYLOAD, PAYLOAD_LEN, "application/octet-stream;bench");
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{30};
+    while (received.load(std::memory_order_acquire) < target) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    return true;
+}
+
+} // namespace
+
+void* operator new(std::size_t n)
+{
+    if (g_count_allocations.load(std::memory_order_relaxed) && !t_main_thread) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (auto p = std::malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+int main(int argc, char** argv)
+{
+    const auto host = (argc > 1) ? argv[1] : flunder::FLUNDER_HOST;
+    const auto port = (argc > 2) ? std::atoi(argv[2]) : flunder::FLUNDER_PORT;
+    const auto n = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 10'000ULL;
+
+    t_main_thread = true;
+
+    auto publisher = flunder::client_t{};
+    auto subscriber = flunder::client_t{};
+    if (publisher.connect(host, port) != 0 || subscriber.connect(host, port) != 0) {
+        std::fprintf(stderr, "Could not connect to %s:%d\n", host, port);
+        return 1;
+    }
+
+    auto received = std::atomic<std::size_t>{};
+    subscriber.subscribe(TOPIC, [&received](flunder::client_t*, const flunder::variable_t* var) {
+        if (var->len() == PAYLOAD_LEN) {
+            received.fetch_add(1, std::memory_order_release);
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    /* warm up the receive buffers of the subscription */
+    if (!publish(publisher, received, 1'000)) {
+        std::fprintf(stderr, "Warm-up incomplete\n");
+        return 1;
+    }
+
+    g_allocations = 0;
+    g_count_allocations = true;
+    const auto complete = publish(publisher, received, n);
+    g_count_allocations = false;
+    subscriber.unsubscribe(TOPIC);
+
+    const auto allocations = g_allocations.load();
+    std::printf(
+        "%10zu samples %10zu allocations %8.3f allocations/sample%s\n",
+        static_cast<std::size_t>(n),
+        allocations,
+        static_cast<double>(allocations) / static_cast<double>(n),
+        complete ? "" : " (incomplete)");
+
+    return (complete && allocations == 0) ? 0 : 1;
+}
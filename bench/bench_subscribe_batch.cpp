@@ -0,0 +1,128 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Measures the per-sample receive overhead of regular and batched subscriptions.
+ *
+ * usage: bench_subscribe_batch [host] [port] [samples]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "flunder/client.h"
+
+namespace {
+
+constexpr auto TOPIC = "flecs/flunder/bench/subscribe_batch";
+
+auto wait_for(const std::atomic<std::size_t>& received, std::size_t n) //
+    -> bool
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{30};
+    while (received.load(std::memory_order_acquire) < n) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+template <typename Subscribe>
+auto run(
+    const char* name,
+    flunder::client_t& publisher,
+    flunder::client_t& subscriber,
+    std::size_t n,
+    Subscribe&& subscribe) //
+    -> void
+{
+    auto received = std::atomic<std::size_t>{};
+    auto callbacks = std::atomic<std::size_t>{};
+    subscribe(subscriber, received, callbacks);
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    const auto payload = std::uint64_t{};
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        publisher.publish(TOPIC, &payload, sizeof(payload));
+    }
+    const auto complete = wait_for(received, n);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    subscriber.unsubscribe(TOPIC);
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    std::fprintf(
+        stdout,
+        "%-12s %10zu samples %10zu callbacks %10.1f ns/sample%s\n",
+        name,
+        received.load(),
+        callbacks.load(),
+        static_cast<double>(ns) / static_cast<double>(n),
+        complete ? "" : " (incomplete)");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto host = (argc > 1) ? argv[1] : flunder::FLUNDER_HOST;
+    const auto port = (argc > 2) ? std::atoi(argv[2]) : flunder::FLUNDER_PORT;
+    const auto n = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 100'000ULL;
+
+    auto publisher = flunder::client_t{};
+    auto subscriber = flunder::client_t{};
+    if (publisher.connect(host, port) != 0 || subscriber.connect(host, port) != 0) {
+        std::fprintf(stderr, "Could not connect to %s:%d\n", host, port);
+        return 1;
+    }
+
+    run("per-sample",
+        publisher,
+        subscriber,
+        n,
+        [](flunder::client_t& client, auto& received, auto& callbacks) {
+            client.subscribe(
+                TOPIC,
+                [r = &received, c = &callbacks](flunder::client_t*, const flunder::variable_t*) {
+                    c->fetch_add(1, std::memory_order_relaxed);
+                    r->fetch_add(1, std::memory_order_release);
+                });
+        });
+
+    for (const auto batch_size : {1, 16, 256}) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "batch-%d", batch_size);
+        run(name,
+            publisher,
+            subscriber,
+            n,
+            [batch_size](flunder::client_t& client, auto& received, auto& callbacks) {
+                client.subscribe_batch(
+                    TOPIC,
+                    [r = &received, c = &callbacks](
+                        flunder::client_t*,
+                        std::span<const flunder::variable_t> vars) {
+                        c->fetch_add(1, std::memory_order_relaxed);
+                        r->fetch_add(vars.size(), std::memory_order_release);
+                    },
+                    flunder::batch_options_t{
+                        static_cast<std::size_t>(batch_size),
+                        std::chrono::milliseconds{1}});
+            });
+    }
+}
@@ -0,0 +1,118 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Compares the transport profiles: round-trip latency of small samples and throughput of bulk
+ * samples between two peers linked over tcp on loopback.
+ *
+ * usage: bench_transport [round trips] [bulk samples] [bulk size]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "flunder/client.h"
+#include "round_trip.h"
+
+namespace {
+
+constexpr auto ENDPOINT = "tcp/127.0.0.1:7462";
+constexpr auto PING = "flecs/flunder/bench/transport/ping";
+constexpr auto PONG = "flecs/flunder/bench/transport/pong";
+constexpr auto BULK = "flecs/flunder/bench/transport/bulk";
+
+auto connect(flunder::client_t& a, flunder::client_t& b, flunder::transport_profile_t profile) //
+    -> bool
+{
+    auto options = flunder::connect_options_t{};
+    options.mode = flunder::session_mode_t::peer;
+    options.profile = profile;
+    options.listen = {ENDPOINT};
+    if (a.connect(options) != 0) {
+        return false;
+    }
+    options.listen.clear();
+    options.endpoints = {ENDPOINT};
+    return b.connect(options) == 0;
+}
+
+/* returns the time until all n samples of size bytes were received */
+auto throughput(
+    flunder::client_t& publisher, flunder::client_t& subscriber, std::size_t n, std::size_t size) //
+    -> std::chrono::nanoseconds
+{
+    auto received = std::atomic<std::size_t>{};
+    subscriber.subscribe(BULK, [&received](flunder::client_t*, const flunder::variable_t*) {
+        received.fetch_add(1, std::memory_order_release);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    const auto payload = std::string(size, 'x');
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = std::size_t{}; i < n; ++i) {
+        publisher.publish(BULK, payload.data(), payload.size());
+    }
+    const auto deadline = start + std::chrono::seconds{30};
+    while (received.load(std::memory_order_acquire) < n &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    subscriber.unsubscribe(BULK);
+    return time;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto round_trips = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 5'000ULL;
+    const auto samples = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 20'000ULL;
+    const auto size = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 16'384ULL;
+
+    const auto profiles = {
+        std::pair{"balanced", flunder::transport_profile_t::balanced},
+        std::pair{"low_latency", flunder::transport_profile_t::low_latency},
+        std::pair{"high_throughput", flunder::transport_profile_t::high_throughput},
+        std::pair{"constrained_memory", flunder::transport_profile_t::constrained_memory},
+    };
+    std::printf("%-20s %12s %12s %14s\n", "profile", "p50 rtt", "p99 rtt", "throughput");
+    for (const auto& [name, profile] : profiles) {
+        auto a = flunder::client_t{};
+        auto b = flunder::client_t{};
+        if (!connect(a, b, profile)) {
+            std::printf("%-20s could not connect\n", name);
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+        const auto rtts = bench::round_trips(b, a, PING, PONG, round_trips);
+        const auto time = throughput(b, a, samples, size);
+
+        const auto mib = static_cast<double>(samples * size) / (1024.0 * 1024.0);
+        std::printf(
+            "%-20s %9.1f us %9.1f us %9.1f MiB/s\n",
+            name,
+            bench::percentile_us(rtts, 50),
+            bench::percentile_us(rtts, 99),
+            mib / std::chrono::duration<double>(time).count());
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Compares typed access to variable values through variable_t::try_as with the atof/stod and
+ * atoll/stoll patterns found in consumers. Values are synthesized, so no router is needed.
+ *
+ * usage: bench_variable_as [variables]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "flunder/variable.h"
+
+namespace {
+
+template <typename Convert>
+auto run(const char* name, const std::vector<flunder::variable_t>& vars, Convert&& convert) //
+    -> void
+{
+    /* summed up so the conversions cannot be optimized away */
+    auto sum = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& var : vars) {
+        sum += convert(var);
+    }
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    std::printf(
+        "%-16s %8.1f ns/value  (sum %g)\n",
+        name,
+        std::chrono::duration<double, std::nano>(time).count() / static_cast<double>(vars.size()),
+        sum);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1'000'000ULL;
+
+    auto ints = std::vector<flunder::variable_t>{};
+    auto doubles = std::vector<flunder::variable_t>{};
+    ints.reserve(n);
+    doubles.reserve(n);
+    for (auto i = std::size_t{}; i < n; ++i) {
+        const auto value = static_cast<std::int64_t>(i * 7919);
+        ints.emplace_back("topic", std::to_string(value), "text/plain;int64", "");
+        doubles.emplace_back("topic", std::to_string(value / 1000.0), "text/plain;float64", "");
+    }
+
+    run("atoll", ints, [](const flunder::variable_t& var) {
+        return static_cast<double>(std::atoll(var.value().data()));
+    });
+    run("stoll", ints, [](const flunder::variable_t& var) {
+        return static_cast<double>(std::stoll(std::string{var.value()}));
+    });
+    run("try_as<int64_t>", ints, [](const flunder::variable_t& var) {
+        return static_cast<double>(std::get<1>(var.try_as<std::int64_t>()));
+    });
+    run("atof", doubles, [](const flunder::variable_t& var) {
+        return std::atof(var.value().data());
+    });
+    run("stod", doubles, [](const flunder::variable_t& var) {
+        return std::stod(std::string{var.value()});
+    });
+    run("try_as<double>", doubles, [](const flunder::variable_t& var) {
+        return std::get<1>(var.try_as<double>());
+    });
+
+    return 0;
+}
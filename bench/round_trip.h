@@ -0,0 +1,82 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/* Round-trip measurement shared by the latency benchmarks */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flunder/client.h"
+
+namespace bench {
+
+/* pinger publishes sequence numbers on ping, which ponger echoes on pong; returns the sorted
+ * round-trip times of n samples, waiting at most a second for each */
+inline auto round_trips(
+    flunder::client_t& pinger,
+    flunder::client_t& ponger,
+    const std::string& ping,
+    const std::string& pong,
+    std::size_t n) //
+    -> std::vector<std::chrono::nanoseconds>
+{
+    ponger.subscribe(ping, [pong](flunder::client_t* client, const flunder::variable_t* var) {
+        client->publish(pong, var->value().data(), var->len());
+    });
+    auto received = std::atomic<std::uint64_t>{};
+    pinger.subscribe(pong, [&received](flunder::client_t*, const flunder::variable_t* var) {
+        auto seqno = std::uint64_t{};
+        std::memcpy(&seqno, var->value().data(), std::min(var->len(), sizeof(seqno)));
+        received.store(seqno, std::memory_order_release);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    auto rtts = std::vector<std::chrono::nanoseconds>{};
+    rtts.reserve(n);
+    for (auto seqno = std::uint64_t{1}; seqno <= n; ++seqno) {
+        const auto start = std::chrono::steady_clock::now();
+        pinger.publish(ping, &seqno, sizeof(seqno));
+        const auto deadline = start + std::chrono::seconds{1};
+        while (received.load(std::memory_order_acquire) != seqno &&
+               std::chrono::steady_clock::now() < deadline) {
+        }
+        rtts.push_back(std::chrono::steady_clock::now() - start);
+    }
+    std::sort(rtts.begin(), rtts.end());
+
+    pinger.unsubscribe(pong);
+    ponger.unsubscribe(ping);
+    return rtts;
+}
+
+/* percentile p of sorted round-trip times, in microseconds */
+inline auto percentile_us(const std::vector<std::chrono::nanoseconds>& rtts, std::size_t p) //
+    -> double
+{
+    if (rtts.empty()) {
+        return 0.0;
+    }
+    const auto i = std::min(rtts.size() * p / 100, rtts.size() - 1);
+    return std::chrono::duration<double, std::micro>(rtts[i]).count();
+}
+
+} // namespace bench
@@ -74,12 +74,11 @@ int main(void)
         flunder_publish_string(flunder_client, "flecs/flunder/c/string", "Hello from C!");
         sleep(5);
 
-        variable_t* vars;
-        size_t n;
-        flunder_get(flunder_client, "**", &vars, &n);
+        void* results;
+        flunder_get_result_set(flunder_client, "**", &results);
         fprintf(stdout, "get() result:\n");
-        print_variables(vars, n);
-        flunder_variable_list_destroy(vars, n);
+        print_variables(flunder_result_set_at(results, 0), flunder_result_set_size(results));
+        flunder_result_set_destroy(results);
     }
 
     flunder_remove_mem_storage(flunder_client, "flunder-c");
@@ -46,17 +46,21 @@ void flunder_receive_callback(flunder::client_t* client, const flunder::variable
         now);
 
     if (var->topic() == "flecs/flunder/cpp/int") {
-        const auto i = std::atoll(var->value().data());
-        std::fprintf(stdout, "\tValue: %lld\n", i);
+        const auto i = var->as<std::int32_t>();
+        std::fprintf(stdout, "\tValue: %" PRIi32 "\n", i);
     } else if (var->topic() == "flecs/flunder/cpp/double") {
-        const auto d = std::atof(var->value().data());
+        const auto d = var->as<double>();
         std::fprintf(stdout, "\tValue: %lf\n", d);
     } else if (var->topic() == "flecs/flunder/cpp/string") {
         std::fprintf(stdout, "\tValue: %s\n", var->value().data());
     } else if (var->topic() == "flecs/flunder/cpp/timestamp") {
-        const auto t1 = std::stoll(var->value().data());
+        const auto [res, t1] = var->try_as<std::int64_t>();
+        if (res != 0) {
+            std::fprintf(stdout, "\tInvalid timestamp %s\n", var->value().data());
+            return;
+        }
         const auto diff = now - t1;
-        std::fprintf(stdout, "\tMessage sent @%lld (%lld ns ago)\n", t1, diff);
+        std::fprintf(stdout, "\tMessage sent @%" PRIi64 " (%" PRIi64 " ns ago)\n", t1, diff);
     }
 }
 
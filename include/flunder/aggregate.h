@@ -0,0 +1,87 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "flunder/history.h"
+#include "flunder/variable.h"
+
+namespace flunder {
+
+/*! Aggregates of all samples with timestamps in [start, start + width) */
+struct bucket_t
+{
+    std::int64_t start;
+    std::size_t count;
+    double min;
+    double max;
+    double sum;
+    /*! value of the oldest sample */
+    double first;
+    /*! value of the newest sample */
+    double last;
+
+    auto avg() const noexcept //
+        -> double
+    {
+        return sum / static_cast<double>(count);
+    }
+};
+
+/*! @brief Streaming downsampling into fixed time buckets
+ *
+ * Buckets are aligned to multiples of width since the Unix epoch. Samples have to be pushed in
+ * ascending timestamp order, so every bucket is complete once a newer one has been started.
+ */
+class aggregator_t
+{
+public:
+    FLECS_EXPORT explicit aggregator_t(std::chrono::nanoseconds width);
+
+    /*! aggregates samples, which have to be sorted by timestamp */
+    FLECS_EXPORT auto push(std::span<const sample_t> samples) //
+        -> void;
+    /*! merges a partial aggregate of samples within a single bucket, starting at partial.start */
+    FLECS_EXPORT auto push(const bucket_t& partial) //
+        -> void;
+
+    /*! start of the bucket timestamp falls into */
+    FLECS_EXPORT auto bucket_start(std::int64_t timestamp) const noexcept //
+        -> std::int64_t;
+
+    FLECS_EXPORT auto buckets() const noexcept //
+        -> const std::vector<bucket_t>&;
+    /*! returns all buckets aggregated so far and starts over */
+    FLECS_EXPORT auto take() //
+        -> std::vector<bucket_t>;
+
+private:
+    std::int64_t _width;
+    std::vector<bucket_t> _buckets;
+};
+
+/*! Aggregates numeric results of a get per topic. Non-numeric values are skipped. */
+FLECS_EXPORT auto aggregate(std::span<const variable_t> vars, std::chrono::nanoseconds width) //
+    -> std::map<std::string, std::vector<bucket_t>, std::less<>>;
+
+} // namespace flunder
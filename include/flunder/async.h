@@ -0,0 +1,155 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "flunder/variable.h"
+
+namespace flunder {
+
+class client_t;
+
+namespace impl {
+struct stream_state_t;
+} // namespace impl
+
+/*! Resumes a suspended coroutine. Awaitables returned by client_t hand their continuation to the
+ * executor of the client, so results can be resumed on an arbitrary scheduler. Without an
+ * executor, publishes resume inline on the awaiting thread, while gets and subscription streams,
+ * which are completed by zenoh callbacks, resume on a thread owned by the client. Coroutines may
+ * therefore unsubscribe, disconnect or await further operations. An executor resuming inline
+ * runs the coroutine inside the zenoh callback instead, where none of this is allowed. */
+using executor_t = std::function<void(std::coroutine_handle<>)>;
+
+/*! @brief Awaitable result of client_t::async_get
+ *
+ * Resumes with the same result as client_t::get once all replies have been received, without
+ * blocking a thread while the query is in flight.
+ */
+class get_awaitable_t
+{
+public:
+    FLECS_EXPORT get_awaitable_t(const client_t* client, std::string_view topic);
+
+    auto await_ready() const noexcept //
+        -> bool
+    {
+        return false;
+    }
+    FLECS_EXPORT auto await_suspend(std::coroutine_handle<> handle) //
+        -> void;
+    FLECS_EXPORT auto await_resume() //
+        -> std::tuple<int, std::vector<variable_t>>;
+
+private:
+    const client_t* _client;
+    std::string _topic;
+    std::tuple<int, std::vector<variable_t>> _result;
+};
+
+/*! @brief Awaitable result of client_t::async_publish
+ *
+ * Performs the publish when awaited and resumes on the executor of the client once the sample has
+ * been handed to the session.
+ */
+class publish_awaitable_t
+{
+public:
+    FLECS_EXPORT publish_awaitable_t(const client_t* client, std::function<int()> publish);
+
+    auto await_ready() const noexcept //
+        -> bool
+    {
+        return false;
+    }
+    FLECS_EXPORT auto await_suspend(std::coroutine_handle<> handle) //
+        -> bool;
+    FLECS_EXPORT auto await_resume() const noexcept //
+        -> int;
+
+private:
+    const client_t* _client;
+    std::function<int()> _publish;
+    int _res;
+};
+
+/*! @brief Asynchronous stream of samples received on a subscription
+ *
+ * Created through client_t::async_subscribe. Samples are queued until they are consumed through
+ * next(). The stream unsubscribes when closed or destroyed, so the client has to outlive it.
+ */
+class subscription_stream_t
+{
+public:
+    class next_awaitable_t
+    {
+    public:
+        explicit next_awaitable_t(impl::stream_state_t* state)
+            : _state{state}
+        {}
+
+        FLECS_EXPORT auto await_ready() const noexcept //
+            -> bool;
+        FLECS_EXPORT auto await_suspend(std::coroutine_handle<> handle) //
+            -> bool;
+        /*! returns std::nullopt once the stream has been closed and all samples are consumed */
+        FLECS_EXPORT auto await_resume() //
+            -> std::optional<variable_t>;
+
+    private:
+        impl::stream_state_t* _state;
+    };
+
+    FLECS_EXPORT subscription_stream_t();
+
+    FLECS_EXPORT subscription_stream_t(const subscription_stream_t&) = delete;
+    FLECS_EXPORT subscription_stream_t(subscription_stream_t&& other) noexcept;
+
+    FLECS_EXPORT subscription_stream_t& operator=(const subscription_stream_t&) = delete;
+    FLECS_EXPORT subscription_stream_t& operator=(subscription_stream_t&& other) noexcept;
+
+    FLECS_EXPORT ~subscription_stream_t();
+
+    FLECS_EXPORT auto is_open() const noexcept //
+        -> bool;
+
+    /*! awaitable yielding the next sample of the subscription */
+    FLECS_EXPORT auto next() //
+        -> next_awaitable_t;
+
+    /*! unsubscribes and resumes a pending next() with std::nullopt */
+    FLECS_EXPORT auto close() //
+        -> void;
+
+private:
+    friend class client_t;
+
+    FLECS_EXPORT friend auto swap(subscription_stream_t& lhs, subscription_stream_t& rhs) noexcept //
+        -> void;
+
+    client_t* _client;
+    std::string _topic;
+    std::shared_ptr<impl::stream_state_t> _state;
+};
+
+} // namespace flunder
@@ -27,6 +27,10 @@
 #endif // FLECS_FLUNDER_PORT
 #endif // __cplusplus
 
+#include "flunder/column_set.h"
+#include "flunder/get_stream.h"
+#include "flunder/result_set.h"
+#include "flunder/serve.h"
 #include "flunder/variable.h"
 
 #ifndef __cplusplus
@@ -34,13 +38,24 @@
 #include <stdbool.h>
 #else
 
+#include <chrono>
 #include <cinttypes>
 #include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <span>
+#include <string>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
+#include "flunder/aggregate.h"
+#include "flunder/async.h"
+#include "flunder/history.h"
+#include "flunder/query.h"
+
 namespace flunder {
 namespace impl {
 class client_t;
@@ -51,6 +66,137 @@ constexpr const char* FLUNDER_HOST = "flecs-flunder";
 /*! Port of the default flunder broker */
 constexpr const int FLUNDER_PORT = 7447;
 
+class client_t;
+
+/*! Callback bound at compile time: invoke is called with obj for every sample, destroy once the
+ * subscription ends. Used by the templated client_t::subscribe overload. */
+struct subscribe_delegate_t
+{
+    void (*invoke)(void* obj, client_t* client, const variable_t* var);
+    void* obj;
+    void (*destroy)(void* obj);
+};
+
+/*! Accumulation limits of batched subscriptions. A batch is delivered once it holds max_items
+ * samples or its oldest sample has been pending for max_delay, whichever comes first, by a
+ * thread the client shares between its batched subscriptions. A zero max_delay delivers every
+ * sample on its own, directly from the receiving thread. */
+struct batch_options_t
+{
+    std::size_t max_items = 64;
+    std::chrono::microseconds max_delay = std::chrono::milliseconds{1};
+};
+
+/*! Configuration of a storage kept by the client itself, see client_t::add_local_storage */
+struct local_storage_options_t
+{
+    /*! directory holding the segment files, created if it does not exist */
+    std::string path;
+    /*! size of each segment file; bounds the size of a single record */
+    std::size_t segment_size = 16 * 1024 * 1024;
+    /*! upper bound for the size of all segments, 0 for unlimited */
+    std::size_t max_size = 0;
+    /*! drop records once they are older than max_age, 0 to keep records regardless of age */
+    std::chrono::seconds max_age = {};
+    /*! maximum time recorded samples may stay in the page cache only, i.e. may be lost on power
+     * loss; 0 writes every sample through to disk */
+    std::chrono::milliseconds sync_interval = std::chrono::milliseconds{100};
+};
+
+/*! How a session takes part in the zenoh network, see connect_options_t::mode */
+enum class session_mode_t {
+    /*! all traffic passes through a router */
+    client,
+    /*! direct links to other peers, so samples between co-located processes skip the router */
+    peer,
+};
+
+/*! Presets of zenoh transport settings, see connect_options_t::profile */
+enum class transport_profile_t {
+    /*! zenoh defaults */
+    balanced,
+    /*! no batching and short queues, so samples are sent right away; lost links are detected
+     * within a second */
+    low_latency,
+    /*! large batches and deep queues for bulk transfers */
+    high_throughput,
+    /*! small batches and buffers and a single transmission thread */
+    constrained_memory,
+};
+
+/*! Configuration of a resilient connection, see client_t::connect */
+struct connect_options_t
+{
+    /*! zenoh locators of routers, e.g. "tcp/flecs-flunder:7447" or, for processes on the same
+     * host, "unixsock-stream//run/flunder.sock". The client connects to the first reachable one
+     * and fails over to the others when its router is lost. Peers may list other peers, too. */
+    std::vector<std::string> endpoints;
+    session_mode_t mode = session_mode_t::client;
+    /*! locators a peer accepts links from other peers on. Peers listening on each other's
+     * locators, or finding each other by scouting, need no router at all; endpoints may then be
+     * empty. */
+    std::vector<std::string> listen;
+    /*! discover other peers by multicast scouting */
+    bool scouting = false;
+    transport_profile_t profile = transport_profile_t::balanced;
+    /*! zenoh configuration applied on top of the profile, mapping keys to JSON5 values, e.g.
+     * {"transport/link/tx/lease", "2000"} */
+    std::map<std::string, std::string> config;
+    /*! share one session with all clients of the process connecting with equal options, instead
+     * of opening a session of its own. Every client keeps its own subscriptions, queryables and
+     * storages; the session is closed once the last client disconnects, so reconnect() only
+     * declares everything again while other clients still use it. */
+    bool shared_session = false;
+    /*! number of sessions publishes are spread over, so threads publishing concurrently do not
+     * contend for one session. Each topic is always published through the same session, keeping
+     * its samples in order; subscriptions, queries and storages use the first session only. */
+    std::size_t shards = 1;
+    /*! delay before reconnecting after the router is lost, doubled after every failed attempt up
+     * to reconnect_delay_max */
+    std::chrono::milliseconds reconnect_delay_min = std::chrono::milliseconds{100};
+    std::chrono::milliseconds reconnect_delay_max = std::chrono::seconds{10};
+    /*! interval at which the connection to the router is checked. A shared session is checked
+     * once for all of its clients, at the interval of the client that opened it. */
+    std::chrono::milliseconds health_interval = std::chrono::milliseconds{500};
+    /*! publishes kept while connect_async is still waiting for a router; once exceeded, further
+     * publishes fail. Not used while the outbox is enabled, which buffers them instead. */
+    std::size_t max_queued_publishes = 1024;
+};
+
+/*! State of the connection to the router, see client_t::on_state_change */
+enum class connection_state_t {
+    disconnected,
+    /*! connect_async is waiting for a router; publishes and subscriptions are queued */
+    connecting,
+    connected,
+    /*! the router was lost and the session is being re-established in the background */
+    reconnecting,
+};
+
+/*! Configuration of the durable publish buffer, see client_t::enable_outbox */
+struct outbox_options_t
+{
+    /*! file holding buffered samples, created if it does not exist */
+    std::string path;
+    /*! size of the file; once full, the oldest buffered samples are discarded */
+    std::size_t max_size = 64 * 1024 * 1024;
+    /*! maximum number of buffered samples replayed per second once the router is reachable */
+    std::size_t replay_rate = 1000;
+};
+
+/*! Counters of the durable publish buffer since it was enabled */
+struct outbox_stats_t
+{
+    /*! samples written to the outbox instead of being published */
+    std::uint64_t buffered;
+    /*! buffered samples published after the router became reachable again */
+    std::uint64_t replayed;
+    /*! buffered samples dropped because the outbox was full */
+    std::uint64_t discarded;
+    /*! samples currently waiting in the outbox, including those of previous runs */
+    std::uint64_t pending;
+};
+
 class client_t
 {
 public:
@@ -82,16 +228,50 @@ public:
         -> int;
     FLECS_EXPORT auto connect(std::string_view host, int port) //
         -> int;
+    /* connect to the first reachable of several routers. Lost connections are re-established
+     * in the background, failing over to other endpoints; subscriptions, queryables and storages
+     * are restored transparently. */
+    FLECS_EXPORT auto connect(connect_options_t options) //
+        -> int;
+
+    /* connect in the background, retrying with backoff until one of the routers is reachable,
+     * and return immediately. Publishes and subscriptions issued in the meantime are queued and
+     * applied once the session is established. The future and cbk receive 0 once connected,
+     * -EINVAL right away if zenoh rejects the resulting config, or -ECANCELED if the client is
+     * disconnected before; cbk must not connect or disconnect. */
+    using connect_cbk_t = std::function<void(int)>;
+    FLECS_EXPORT auto connect_async(connect_options_t options, connect_cbk_t cbk = {}) //
+        -> std::future<int>;
 
     FLECS_EXPORT auto is_connected() const noexcept //
         -> bool;
 
+    /* observe changes of the connection state. cbk is invoked from the thread causing the change
+     * and must not connect or disconnect the client, nor another client sharing its session. */
+    using state_cbk_t = std::function<void(connection_state_t)>;
+    FLECS_EXPORT auto on_state_change(state_cbk_t cbk) //
+        -> void;
+    FLECS_EXPORT auto state() const noexcept //
+        -> connection_state_t;
+
+    /*! replaces the session, keeping subscriptions, queryables and storages. Publishes, gets and
+     * erases issued from other threads meanwhile fail, or are buffered by the outbox */
     FLECS_EXPORT auto reconnect() //
         -> int;
 
     FLECS_EXPORT auto disconnect() //
         -> int;
 
+    /* buffer publishes in a memory-mapped file while no router is reachable or publishing fails,
+     * and replay them in order with their original timestamps once the router is back */
+    FLECS_EXPORT auto enable_outbox(outbox_options_t options) //
+        -> int;
+    /* stop buffering; samples still pending stay in the file and are replayed when re-enabled */
+    FLECS_EXPORT auto disable_outbox() //
+        -> int;
+    FLECS_EXPORT auto outbox_stats() const //
+        -> outbox_stats_t;
+
     /* publish typed data to live subscribers */
     /* bool */
     FLECS_EXPORT auto publish(std::string_view topic, bool value) const //
@@ -133,33 +313,142 @@ public:
         std::string_view topic, const void* data, size_t len, std::string_view encoding) const //
         -> int;
 
+    /* The variable passed to subscribe callbacks views receive buffers of the subscription that
+     * are reused for the next sample, so it and its views are only valid during the callback.
+     * Copies of it own their data and may be kept. */
     using subscribe_cbk_t = std::function<void(client_t*, const variable_t*)>;
     using subscribe_cbk_userp_t = std::function<void(client_t*, const variable_t*, const void*)>;
 
     /* subscribe to live data */
     FLECS_EXPORT auto subscribe(std::string_view topic, subscribe_cbk_t cbk) //
         -> int;
+    /* subscribe to live data with a callback bound at compile time; takes ownership of delegate,
+     * which is destroyed on unsubscribe or immediately if subscribing fails */
+    FLECS_EXPORT auto subscribe(std::string_view topic, subscribe_delegate_t delegate) //
+        -> int;
+    /* subscribe to live data with an arbitrary callable, invoked without type-erased copies */
+    template <typename F>
+        requires std::is_invocable_v<std::decay_t<F>&, client_t*, const variable_t*>
+    auto subscribe(std::string_view topic, F&& cbk) //
+        -> int
+    {
+        using fn_t = std::decay_t<F>;
+        return subscribe(
+            topic,
+            subscribe_delegate_t{
+                [](void* obj, client_t* client, const variable_t* var) {
+                    (*static_cast<fn_t*>(obj))(client, var);
+                },
+                new fn_t(std::forward<F>(cbk)),
+                [](void* obj) { delete static_cast<fn_t*>(obj); }});
+    }
     /* subscribe to live data with userdata */
     FLECS_EXPORT auto subscribe(
         std::string_view topic, subscribe_cbk_userp_t cbk, const void* userp) //
         -> int;
+    using subscribe_batch_cbk_t = std::function<void(client_t*, std::span<const variable_t>)>;
+
+    /* subscribe to live data, delivered in batches of samples */
+    FLECS_EXPORT auto subscribe_batch(
+        std::string_view topic, subscribe_batch_cbk_t cbk, batch_options_t options = {}) //
+        -> int;
     /* unsubscribe from live data */
     FLECS_EXPORT auto unsubscribe(std::string_view topic) //
         -> int;
 
+    /* answer gets for key_expr from within this process, e.g. from data already held in memory */
+    FLECS_EXPORT auto serve(std::string_view key_expr, serve_cbk_t cbk) //
+        -> int;
+    FLECS_EXPORT auto unserve(std::string_view key_expr) //
+        -> int;
+
     FLECS_EXPORT auto add_mem_storage(std::string_view name, std::string_view topic) //
         -> int;
     FLECS_EXPORT auto remove_mem_storage(std::string_view name) //
         -> int;
+    /* record data matching key_expr into segment files on local disk, surviving restarts, and
+     * answer gets including time range queries for it */
+    FLECS_EXPORT auto add_local_storage(
+        std::string_view name, std::string_view key_expr, local_storage_options_t options) //
+        -> int;
+    FLECS_EXPORT auto remove_local_storage(std::string_view name) //
+        -> int;
 
     /* get data from storage */
     FLECS_EXPORT auto get(std::string_view topic) const //
         -> std::tuple<int, std::vector<variable_t> >;
+
+    /* receives one reply of a streaming get; return false to cancel the remaining replies */
+    using get_reply_cbk_t = std::function<bool(const variable_t*)>;
+
+    /* get data from storage, processing replies as they arrive with at most depth buffered */
+    FLECS_EXPORT auto get(
+        std::string_view topic,
+        get_reply_cbk_t cbk,
+        std::size_t depth = FLUNDER_GET_DEPTH) const //
+        -> int;
+    /* get data for several topics at once, issuing all queries concurrently. Returns 0 once all
+     * queries completed or -ETIMEDOUT if timeout expired first, in which case the results hold
+     * the replies received until then. Returns -EINVAL if a topic is no valid key expression and
+     * -1 if a query could not be issued; results of the other topics are delivered regardless.
+     * Results are in the order of topics. */
+    FLECS_EXPORT auto get_many(
+        std::span<const std::string_view> topics,
+        std::chrono::milliseconds timeout = std::chrono::seconds{10}) const //
+        -> std::tuple<int, std::vector<std::vector<variable_t>>>;
+    /* get data from storage as a stream of replies with at most depth buffered */
+    FLECS_EXPORT auto get_stream(std::string_view topic, std::size_t depth = FLUNDER_GET_DEPTH) const //
+        -> std::tuple<int, get_stream_t>;
+
+    /* get data matching a selector, e.g. a time range of historical data. Returns -ETIMEDOUT along
+     * with the replies received so far if the query runs into its timeout */
+    FLECS_EXPORT auto get(const query_t& query) const //
+        -> std::tuple<int, std::vector<variable_t> >;
+    FLECS_EXPORT auto get(
+        const query_t& query,
+        get_reply_cbk_t cbk,
+        std::size_t depth = FLUNDER_GET_DEPTH) const //
+        -> int;
+    FLECS_EXPORT auto get_stream(const query_t& query, std::size_t depth = FLUNDER_GET_DEPTH) const //
+        -> std::tuple<int, get_stream_t>;
+    /* like get, but stores all variables in a single arena instead of allocating per variable.
+     * With result_mode_t::zero_copy, payloads are borrowed from the replies instead of copied */
+    FLECS_EXPORT auto get_result_set(
+        const query_t& query, result_mode_t mode = result_mode_t::copy) const //
+        -> std::tuple<int, result_set_t>;
+    /* like get, but decodes numeric values into columns for bulk processing */
+    FLECS_EXPORT auto get_columns(const query_t& query) const //
+        -> std::tuple<int, column_set_t>;
+    /* list keys stored below prefix, e.g. "flecs/config". Values are left empty; encoding and
+     * timestamp are filled in */
+    FLECS_EXPORT auto list_keys(std::string_view prefix) const //
+        -> std::tuple<int, std::vector<variable_t>>;
     /* delete data from storage */
     FLECS_EXPORT auto erase(std::string_view topic) //
         -> int;
 
+    /* set executor used to resume coroutines awaiting async operations */
+    FLECS_EXPORT auto set_executor(executor_t executor) //
+        -> void;
+
+    /* get data from storage without blocking the calling thread */
+    FLECS_EXPORT auto async_get(std::string_view topic) const //
+        -> get_awaitable_t;
+    /* publish data and resume on the executor once it has been handed to the session */
+    template <typename... Args>
+    auto async_publish(std::string_view topic, Args... args) const //
+        -> publish_awaitable_t
+    {
+        return publish_awaitable_t{this, [=, this]() { return publish(topic, args...); }};
+    }
+    /* subscribe to live data as an asynchronous stream of samples */
+    FLECS_EXPORT auto async_subscribe(std::string_view topic) //
+        -> subscription_stream_t;
+
 private:
+    friend class get_awaitable_t;
+    friend class publish_awaitable_t;
+
     FLECS_EXPORT friend auto swap(client_t& lhs, client_t& rhs) noexcept //
         -> void;
 
@@ -171,6 +460,7 @@ extern "C" {
 
 typedef void (*flunder_subscribe_cbk_t)(void*, const variable_t*);
 typedef void (*flunder_subscribe_cbk_userp_t)(void*, const variable_t*, void*);
+typedef void (*flunder_subscribe_batch_cbk_t)(void*, const variable_t*, size_t, void*);
 
 FLECS_EXPORT void* flunder_client_new(void);
 
@@ -178,21 +468,75 @@ FLECS_EXPORT void flunder_client_destroy(void* flunder);
 
 FLECS_EXPORT int flunder_connect(void* flunder, const char* host, int port);
 
+typedef enum flunder_session_mode_t {
+    FLUNDER_MODE_CLIENT,
+    FLUNDER_MODE_PEER,
+} flunder_session_mode_t;
+
+typedef enum flunder_transport_profile_t {
+    FLUNDER_PROFILE_BALANCED,
+    FLUNDER_PROFILE_LOW_LATENCY,
+    FLUNDER_PROFILE_HIGH_THROUGHPUT,
+    FLUNDER_PROFILE_CONSTRAINED_MEMORY,
+} flunder_transport_profile_t;
+
+/** Mirrors connect_options_t; endpoints and listen point to arrays of locators, config_keys and
+ * config_values to config_len zenoh configuration keys and their JSON5 values. Zero-initialized
+ * fields select the defaults. */
+typedef struct flunder_connect_options_t
+{
+    const char* const* endpoints;
+    size_t endpoints_len;
+    const char* const* listen;
+    size_t listen_len;
+    flunder_session_mode_t mode;
+    bool scouting;
+    flunder_transport_profile_t profile;
+    const char* const* config_keys;
+    const char* const* config_values;
+    size_t config_len;
+    bool shared_session;
+    size_t shards;
+} flunder_connect_options_t;
+
+FLECS_EXPORT int flunder_connect_options(void* flunder, const flunder_connect_options_t* options);
+
 FLECS_EXPORT int flunder_is_connected(const void* flunder);
 
 FLECS_EXPORT int flunder_reconnect(void* flunder);
 
 FLECS_EXPORT int flunder_disconnect(void* flunder);
 
+/** var is only valid during the callback; flunder_variable_clone keeps a copy */
 FLECS_EXPORT int flunder_subscribe(void* flunder, const char* topic, flunder_subscribe_cbk_t cbk);
 FLECS_EXPORT int flunder_subscribe_userp(
     void* flunder, const char* topic, flunder_subscribe_cbk_userp_t cbk, const void* userp);
 
+/** vars points to an array of n variables that is only valid during the callback */
+FLECS_EXPORT int flunder_subscribe_batch(
+    void* flunder,
+    const char* topic,
+    flunder_subscribe_batch_cbk_t cbk,
+    size_t max_items,
+    uint64_t max_delay_us,
+    const void* userp);
+
 FLECS_EXPORT int flunder_unsubscribe(void* flunder, const char* topic);
 
-/** make sure to call flunder_variable_list_destroy with the exact values returned */
+/** cbk receives a reply handle to answer through flunder_reply */
+FLECS_EXPORT int flunder_serve(
+    void* flunder, const char* key_expr, flunder_serve_cbk_t cbk, void* userp);
+
+FLECS_EXPORT int flunder_unserve(void* flunder, const char* key_expr);
+
+/** make sure to call flunder_variable_list_destroy with the exact values returned. Prefer
+ * flunder_get_result_set for large results, which does not allocate per variable */
 FLECS_EXPORT int flunder_get(const void* flunder, const char* topic, variable_t** vars, size_t* n);
 
+/** same as flunder_get, but values are left empty */
+FLECS_EXPORT int flunder_list_keys(
+    const void* flunder, const char* prefix, variable_t** vars, size_t* n);
+
 FLECS_EXPORT int flunder_publish_bool(const void* flunder, const char* topic, bool value);
 
 FLECS_EXPORT int flunder_publish_int(const void* flunder, const char* topic, int value);
@@ -0,0 +1,122 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef __cplusplus
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flunder/variable.h"
+
+namespace flunder {
+
+/*! @brief Numeric query results in columnar layout
+ *
+ * Created through client_t::get_columns or by appending variables. Keys, timestamps and values
+ * are kept in separate contiguous columns; values are decoded to double as rows are appended.
+ * Text encodings are parsed eight digits at a time, binary values of eight bytes are copied as
+ * doubles. Rows whose value is no number, e.g. strings or custom encodings, are kept with their
+ * validity bit cleared. Integers beyond 2^53 lose precision.
+ */
+class column_set_t
+{
+public:
+    FLECS_EXPORT column_set_t();
+
+    FLECS_EXPORT column_set_t(const column_set_t&) = delete;
+    FLECS_EXPORT column_set_t(column_set_t&& other) noexcept;
+
+    FLECS_EXPORT column_set_t& operator=(const column_set_t&) = delete;
+    FLECS_EXPORT column_set_t& operator=(column_set_t&& other) noexcept;
+
+    FLECS_EXPORT ~column_set_t();
+
+    /*! appends var as a row */
+    FLECS_EXPORT auto push_back(const variable_t& var) //
+        -> void;
+    /*! appends vars as rows, reserving all columns up front */
+    FLECS_EXPORT auto append(std::span<const variable_t> vars) //
+        -> void;
+
+    /*! prepares for rows with key_bytes of keys in total */
+    FLECS_EXPORT auto reserve(std::size_t rows, std::size_t key_bytes) //
+        -> void;
+
+    FLECS_EXPORT auto clear() noexcept //
+        -> void;
+
+    auto size() const noexcept //
+        -> std::size_t
+    {
+        return _values.size();
+    }
+    auto empty() const noexcept //
+        -> bool
+    {
+        return _values.empty();
+    }
+
+    auto key(std::size_t row) const noexcept //
+        -> std::string_view
+    {
+        return std::string_view{_keys}.substr(
+            _key_offsets[row],
+            _key_offsets[row + 1] - _key_offsets[row]);
+    }
+    /*! nanoseconds since the unix epoch */
+    auto timestamps() const noexcept //
+        -> std::span<const std::uint64_t>
+    {
+        return _timestamps;
+    }
+    /*! 0.0 for rows without a valid value */
+    auto values() const noexcept //
+        -> std::span<const double>
+    {
+        return _values;
+    }
+    /*! one bit per row, least significant bit first */
+    auto validity() const noexcept //
+        -> std::span<const std::uint64_t>
+    {
+        return _validity;
+    }
+    auto valid(std::size_t row) const noexcept //
+        -> bool
+    {
+        return (_validity[row / 64] >> (row % 64)) & 1;
+    }
+    FLECS_EXPORT auto valid_count() const noexcept //
+        -> std::size_t;
+
+private:
+    FLECS_EXPORT friend auto swap(column_set_t& lhs, column_set_t& rhs) noexcept //
+        -> void;
+
+    std::string _keys;
+    std::vector<std::uint32_t> _key_offsets;
+    std::vector<std::uint64_t> _timestamps;
+    std::vector<double> _values;
+    std::vector<std::uint64_t> _validity;
+};
+
+} // namespace flunder
+
+#endif // __cplusplus
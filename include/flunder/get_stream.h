@@ -0,0 +1,153 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "flunder/variable.h"
+
+#ifdef __cplusplus
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+namespace flunder {
+namespace impl {
+class get_stream_t;
+} // namespace impl
+
+/*! Default number of replies buffered by a get before the session applies backpressure */
+constexpr const std::size_t FLUNDER_GET_DEPTH = 64;
+
+/*! @brief Replies of a get, consumed as they arrive
+ *
+ * Created through client_t::get_stream. At most depth replies are buffered, so memory stays
+ * bounded regardless of the size of the result. Destroying or cancelling the stream discards all
+ * replies that have not been consumed.
+ */
+class get_stream_t
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = variable_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const variable_t*;
+        using reference = const variable_t&;
+
+        iterator() = default;
+        explicit iterator(get_stream_t* stream)
+            : _stream{stream}
+            , _var{stream->next()}
+        {}
+
+        auto operator*() const noexcept //
+            -> reference
+        {
+            return *_var;
+        }
+        auto operator->() const noexcept //
+            -> pointer
+        {
+            return _var;
+        }
+        auto operator++() //
+            -> iterator&
+        {
+            _var = _stream->next();
+            return *this;
+        }
+        auto operator++(int) //
+            -> void
+        {
+            ++*this;
+        }
+        auto operator==(std::default_sentinel_t) const noexcept //
+            -> bool
+        {
+            return _var == nullptr;
+        }
+
+    private:
+        get_stream_t* _stream = nullptr;
+        const variable_t* _var = nullptr;
+    };
+
+    FLECS_EXPORT get_stream_t();
+
+    FLECS_EXPORT get_stream_t(const get_stream_t&) = delete;
+    FLECS_EXPORT get_stream_t(get_stream_t&& other) noexcept;
+
+    FLECS_EXPORT get_stream_t& operator=(const get_stream_t&) = delete;
+    FLECS_EXPORT get_stream_t& operator=(get_stream_t&& other) noexcept;
+
+    FLECS_EXPORT ~get_stream_t();
+
+    FLECS_EXPORT auto is_open() const noexcept //
+        -> bool;
+
+    /*! blocks until the next reply arrives. The returned variable does not own its data and stays
+     * valid until the next call; nullptr once all replies have been consumed */
+    FLECS_EXPORT auto next() //
+        -> const variable_t*;
+
+    /*! stops consuming replies and discards all replies not yet received */
+    FLECS_EXPORT auto cancel() //
+        -> void;
+
+    /*! true if the query ran into its timeout, i.e. the replies consumed are incomplete */
+    FLECS_EXPORT auto timed_out() const noexcept //
+        -> bool;
+
+    auto begin() //
+        -> iterator
+    {
+        return iterator{this};
+    }
+    auto end() const noexcept //
+        -> std::default_sentinel_t
+    {
+        return {};
+    }
+
+private:
+    friend class client_t;
+
+    FLECS_EXPORT friend auto swap(get_stream_t& lhs, get_stream_t& rhs) noexcept //
+        -> void;
+
+    std::unique_ptr<impl::get_stream_t> _impl;
+};
+
+} // namespace flunder
+
+#endif // __cplusplus
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** returns NULL on error; destroy with flunder_get_stream_destroy */
+FLECS_EXPORT void* flunder_get_stream_new(const void* flunder, const char* topic, size_t depth);
+
+/** returns NULL once all replies have been consumed; valid until the next call */
+FLECS_EXPORT const variable_t* flunder_get_stream_next(void* stream);
+
+FLECS_EXPORT void flunder_get_stream_destroy(void* stream);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
@@ -0,0 +1,120 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flunder/variable.h"
+
+namespace flunder {
+
+class aggregator_t;
+class client_t;
+
+namespace impl {
+class series_t;
+} // namespace impl
+
+/*! A single numeric sample, timestamp in nanoseconds since the Unix epoch */
+struct sample_t
+{
+    std::int64_t timestamp;
+    double value;
+};
+
+/*! @brief Compressed in-memory history of numeric topics
+ *
+ * Samples are stored per topic in blocks compressed as described in "Gorilla: A Fast, Scalable,
+ * In-Memory Time Series Database" (Pelkonen et al., 2015): timestamps as delta-of-delta, values
+ * XORed with their predecessor. Regularly sampled, slowly changing values take a few bits per
+ * sample instead of the four strings of a variable_t.
+ *
+ * Samples of a topic have to be appended in timestamp order; older samples are rejected. Blocks
+ * entirely older than the retention, measured from the newest sample of their topic, are dropped.
+ * All members are thread-safe.
+ */
+class history_t
+{
+public:
+    /*! Receives decoded samples one block at a time; spans are valid for the duration of the
+     * call, during which the history must not be accessed */
+    using scan_cbk_t = std::function<void(std::span<const sample_t>)>;
+
+    FLECS_EXPORT explicit history_t(
+        std::chrono::nanoseconds retention = std::chrono::hours{1},
+        std::size_t block_size = 1024);
+
+    FLECS_EXPORT history_t(const history_t&) = delete;
+    FLECS_EXPORT history_t& operator=(const history_t&) = delete;
+
+    FLECS_EXPORT ~history_t();
+
+    /*! returns -1 if sample is older than the newest sample of topic */
+    FLECS_EXPORT auto append(std::string_view topic, sample_t sample) //
+        -> int;
+    /*! appends a received variable; returns -1 if its value or timestamp is not numeric */
+    FLECS_EXPORT auto append(const variable_t& var) //
+        -> int;
+
+    /*! subscribes client to topic, appending every received sample. The history has to outlive
+     * the subscription, i.e. unsubscribe from topic before destroying it. */
+    FLECS_EXPORT auto record(client_t& client, std::string_view topic) //
+        -> int;
+
+    /*! decodes all samples of topic with timestamps in [start, end] */
+    FLECS_EXPORT auto range(std::string_view topic, std::int64_t start, std::int64_t end) const //
+        -> std::vector<sample_t>;
+    /*! decodes samples of topic with timestamps in [start, end] block-wise into cbk */
+    FLECS_EXPORT auto scan(
+        std::string_view topic,
+        std::int64_t start,
+        std::int64_t end,
+        const scan_cbk_t& cbk) const //
+        -> void;
+
+    /*! downsamples samples of topic with timestamps in [start, end] into aggregator, which
+     * must not have received newer samples before */
+    FLECS_EXPORT auto aggregate(
+        std::string_view topic,
+        std::int64_t start,
+        std::int64_t end,
+        aggregator_t& aggregator) const //
+        -> void;
+
+    /*! number of samples retained for topic */
+    FLECS_EXPORT auto size(std::string_view topic) const //
+        -> std::size_t;
+    /*! bytes occupied by the compressed samples of all topics */
+    FLECS_EXPORT auto memory_usage() const //
+        -> std::size_t;
+
+private:
+    std::chrono::nanoseconds _retention;
+    std::size_t _block_size;
+    std::map<std::string, std::unique_ptr<impl::series_t>, std::less<>> _series;
+    mutable std::mutex _mutex;
+};
+
+} // namespace flunder
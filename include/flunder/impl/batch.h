@@ -0,0 +1,105 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "flunder/client.h"
+
+namespace flunder {
+namespace impl {
+
+class batch_t;
+
+/*! Delivers the batches of all batched subscriptions of a client that are due, on a single
+ * thread started with the first batch scheduled. A slow callback therefore delays the batches of
+ * other subscriptions of the same client. */
+class batch_flusher_t
+{
+public:
+    batch_flusher_t();
+    /*! stops the thread; batches still scheduled are delivered by their destructors */
+    ~batch_flusher_t();
+
+    batch_flusher_t(const batch_flusher_t&) = delete;
+    batch_flusher_t& operator=(const batch_flusher_t&) = delete;
+
+    /*! delivers batch at deadline, or earlier if it is scheduled earlier already */
+    auto schedule(batch_t* batch, std::chrono::steady_clock::time_point deadline) //
+        -> void;
+    /*! unschedules batch; once this returns, the thread does not deliver it anymore */
+    auto cancel(batch_t* batch) //
+        -> void;
+
+private:
+    auto run() //
+        -> void;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::map<batch_t*, std::chrono::steady_clock::time_point> _scheduled;
+    /*! batch being delivered by the thread, if any */
+    batch_t* _current;
+    bool _stop;
+    std::thread _thread;
+};
+
+/*! Accumulates samples of a batched subscription and delivers them as spans. With a non-zero
+ * max_delay, batches are delivered by the batch_flusher_t of the client; otherwise every sample is
+ * delivered on its own by the thread receiving it. */
+class batch_t
+{
+public:
+    using cbk_t = flunder::client_t::subscribe_batch_cbk_t;
+
+    batch_t(
+        flunder::client_t* client, cbk_t cbk, batch_options_t options, batch_flusher_t* flusher);
+    /*! delivers pending samples */
+    ~batch_t();
+
+    auto push(variable_t var) //
+        -> void;
+
+    /*! delivers vars immediately, in chunks of at most max_items */
+    auto deliver(std::span<const variable_t> vars) //
+        -> void;
+
+    /*! delivers all pending samples; called by the flusher */
+    auto flush() //
+        -> void;
+
+private:
+    /*! delivers all pending samples; lock is released during the callback */
+    auto flush(std::unique_lock<std::mutex>& lock) //
+        -> void;
+
+    flunder::client_t* _client;
+    cbk_t _cbk;
+    batch_options_t _options;
+    batch_flusher_t* _flusher;
+
+    std::mutex _mutex;
+    std::vector<variable_t> _pending;
+    std::vector<variable_t> _spare;
+};
+
+} // namespace impl
+} // namespace flunder
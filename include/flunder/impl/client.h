@@ -16,20 +16,37 @@
 
 #include <zenoh.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <variant>
 
 #include "flunder/client.h"
+#include "flunder/impl/batch.h"
+#include "flunder/impl/resume_thread.h"
+#include "flunder/impl/session_registry.h"
 
 namespace flunder {
 namespace impl {
 
+class get_stream_t;
+class local_storage_t;
+class outbox_t;
+
 struct mem_storage_t
 {
     std::string name;
+    std::string key_expr;
+    /*! router the storage is configured on */
     std::string zid;
 };
 
@@ -38,6 +55,23 @@ inline auto operator<=>(const mem_storage_t& lhs, const mem_storage_t& rhs)
     return lhs.name <=> rhs.name;
 }
 
+/*! Reusable storage backing non-owning variables created on the sample dispatch path */
+struct sample_buffers_t
+{
+    std::string topic;
+    std::string value;
+    std::string encoding;
+    std::string timestamp;
+};
+
+/*! Receive buffers of a subscription. A sample arriving while they are in use, e.g. because the
+ * callback publishes to its own topic, is dispatched as an owning variable instead. */
+struct sample_dispatch_t
+{
+    sample_buffers_t buffers;
+    std::atomic<bool> busy;
+};
+
 class client_t
 {
 public:
@@ -47,15 +81,35 @@ public:
     FLECS_EXPORT auto connect(std::string_view host, int port) //
         -> int;
 
+    FLECS_EXPORT auto connect(connect_options_t options) //
+        -> int;
+
     FLECS_EXPORT auto reconnect() //
         -> int;
 
+    using connect_cbk_t = flunder::client_t::connect_cbk_t;
+    FLECS_EXPORT auto connect_async(connect_options_t options, connect_cbk_t cbk) //
+        -> std::future<int>;
+
     FLECS_EXPORT auto is_connected() const noexcept //
         -> bool;
 
+    using state_cbk_t = flunder::client_t::state_cbk_t;
+    FLECS_EXPORT auto on_state_change(state_cbk_t cbk) //
+        -> void;
+    FLECS_EXPORT auto state() const noexcept //
+        -> connection_state_t;
+
     FLECS_EXPORT auto disconnect() //
         -> int;
 
+    FLECS_EXPORT auto enable_outbox(outbox_options_t options) //
+        -> int;
+    FLECS_EXPORT auto disable_outbox() //
+        -> int;
+    FLECS_EXPORT auto outbox_stats() const //
+        -> outbox_stats_t;
+
     FLECS_EXPORT auto publish(
         std::string_view topic,
         z_owned_bytes_t value,
@@ -150,23 +204,87 @@ public:
         const void* userp) //
         -> int;
 
+    FLECS_EXPORT auto subscribe(
+        flunder::client_t* client, std::string_view topic, subscribe_delegate_t delegate) //
+        -> int;
+
+    using subscribe_batch_cbk_t = flunder::client_t::subscribe_batch_cbk_t;
+    FLECS_EXPORT auto subscribe_batch(
+        flunder::client_t* client,
+        std::string_view topic,
+        subscribe_batch_cbk_t cbk,
+        batch_options_t options) //
+        -> int;
+
     FLECS_EXPORT auto unsubscribe(std::string_view topic) //
         -> int;
 
+    FLECS_EXPORT auto serve(std::string_view key_expr, serve_cbk_t cbk) //
+        -> int;
+
+    FLECS_EXPORT auto unserve(std::string_view key_expr) //
+        -> int;
+
     FLECS_EXPORT auto add_mem_storage(std::string topic, std::string_view name) //
         -> int;
 
     FLECS_EXPORT auto remove_mem_storage(std::string name) //
         -> int;
 
+    FLECS_EXPORT auto add_local_storage(
+        std::string name, std::string_view key_expr, local_storage_options_t options) //
+        -> int;
+
+    FLECS_EXPORT auto remove_local_storage(std::string name) //
+        -> int;
+
     FLECS_EXPORT auto get(std::string_view topic) const //
         -> std::tuple<int, std::vector<variable_t>>;
+    FLECS_EXPORT auto get(const query_t& query) const //
+        -> std::tuple<int, std::vector<variable_t>>;
+
+    FLECS_EXPORT auto get_result_set(
+        const query_t& query, result_mode_t mode = result_mode_t::copy) const //
+        -> std::tuple<int, result_set_t>;
+    FLECS_EXPORT auto get_columns(const query_t& query) const //
+        -> std::tuple<int, column_set_t>;
+
+    FLECS_EXPORT auto get_many(
+        std::span<const std::string_view> topics,
+        std::chrono::milliseconds timeout) const //
+        -> std::tuple<int, std::vector<std::vector<variable_t>>>;
+
+    /*! Issues a query delivering its replies to stream */
+    FLECS_EXPORT auto get_stream(const query_t& query, std::size_t depth, get_stream_t& stream) const //
+        -> int;
+
+    /*! Function pointer to receive the result of an asynchronous get */
+    using get_cbk_t = std::function<void(int, std::vector<variable_t>)>;
+    /*! Issues a query and returns immediately. cbk is invoked exactly once with the same result
+     * get() would return, either from a zenoh thread or from within the call on early errors. */
+    FLECS_EXPORT auto get_async(std::string_view topic, get_cbk_t cbk) const //
+        -> void;
 
     FLECS_EXPORT auto erase(std::string_view topic) //
         -> int;
 
+    FLECS_EXPORT auto set_executor(executor_t executor) //
+        -> void;
+    FLECS_EXPORT auto executor() const noexcept //
+        -> const executor_t&;
+    /*! executor resuming operations completed by zenoh: the one set, or else the resume thread */
+    FLECS_EXPORT auto callback_executor() const //
+        -> executor_t;
+
+    /*! Callback bound through subscribe_delegate_t, owning its callable */
+    struct bound_cbk_t
+    {
+        decltype(subscribe_delegate_t::invoke) _invoke;
+        std::unique_ptr<void, decltype(subscribe_delegate_t::destroy)> _obj;
+    };
+
     /*! Function pointer to receive callback */
-    using subscribe_cbk_var_t = std::variant<subscribe_cbk_t, subscribe_cbk_userp_t>;
+    using subscribe_cbk_var_t = std::variant<subscribe_cbk_t, subscribe_cbk_userp_t, bound_cbk_t>;
 
     struct subscribe_ctx_t
     {
@@ -175,6 +293,16 @@ public:
         subscribe_cbk_var_t _cbk;
         const void* _userp;
         bool _once;
+        /*! set for batched subscriptions, which bypass _cbk */
+        std::unique_ptr<batch_t> _batch;
+        std::unique_ptr<sample_dispatch_t> _dispatch = std::make_unique<sample_dispatch_t>();
+    };
+
+    struct serve_ctx_t
+    {
+        const z_owned_session_t* _session;
+        z_owned_queryable_t _queryable;
+        serve_cbk_t _cbk;
     };
 
 private:
@@ -184,29 +312,156 @@ private:
         z_owned_bytes_t value) const //
         -> int;
 
+    /*! publishes value; a timestamp replaces the one assigned by the router */
+    FLECS_EXPORT auto do_put(
+        std::string_view topic,
+        z_owned_encoding_t encoding,
+        z_owned_bytes_t value,
+        z_timestamp_t* timestamp) const //
+        -> int;
+
+    /*! appends value to the outbox, stamped with the current time */
+    FLECS_EXPORT auto do_buffer(
+        std::string_view topic,
+        z_owned_encoding_t encoding,
+        z_owned_bytes_t value) const //
+        -> int;
+
+    FLECS_EXPORT auto start_outbox() //
+        -> void;
+
     FLECS_EXPORT auto do_subscribe(
         flunder::client_t* client,
         std::string_view topic,
         subscribe_cbk_var_t cbk,
-        const void* userp) //
+        const void* userp,
+        std::unique_ptr<batch_t> batch = {}) //
         -> int;
 
     FLECS_EXPORT auto determine_connected_router_count() const //
         -> int;
+    FLECS_EXPORT auto determine_connected_peer_count() const //
+        -> int;
+    /*! whether a router, or in peer mode another peer, is reachable */
+    auto is_online() const //
+        -> bool;
+    /*! builds the zenoh config for options; returns -EINVAL if zenoh rejects it */
+    static auto make_config(const connect_options_t& options, z_owned_config_t& config) //
+        -> int;
+    auto open_session(const connect_options_t& options, z_owned_session_t& session) //
+        -> int;
+    /*! opens a session, or refers to the shared one if options.shared_session is set */
+    auto acquire_session(const connect_options_t& options) //
+        -> session_ptr_t;
+    /*! opens the sessions beyond the first of a sharded client */
+    auto open_shards(const connect_options_t& options, std::vector<session_ptr_t>& shards) //
+        -> int;
+    /*! session publishing samples of topic */
+    auto publish_session(std::string_view topic) const //
+        -> const z_owned_session_t&;
+    /*! makes session and shards the ones used from now on */
+    auto install_session(session_ptr_t session, std::vector<session_ptr_t> shards) //
+        -> void;
+    auto close_session() //
+        -> void;
+
+    auto declare_subscriber(const std::string& topic, subscribe_ctx_t& ctx) //
+        -> int;
+    auto declare_queryable(const std::string& key_expr, serve_ctx_t& ctx) //
+        -> int;
+    /*! delivers the values currently stored for topic to a new subscription */
+    auto initial_get(const std::string& topic, subscribe_ctx_t& ctx) //
+        -> void;
 
-    std::set<mem_storage_t> _mem_storages;
+    auto set_state(connection_state_t state) //
+        -> void;
+
+    /*! opens the session in the background for connect_async */
+    auto connector() //
+        -> int;
+    auto stop_connector() //
+        -> void;
+    /*! queues a publish while connect_async is in progress, publishes it if connected meanwhile */
+    FLECS_EXPORT auto do_queue(
+        std::string_view topic,
+        z_owned_encoding_t encoding,
+        z_owned_bytes_t value) const //
+        -> int;
+
+    auto connected_router_zid(std::string& zid) const //
+        -> int;
+    /*! configures storage on the router identified by storage.zid */
+    auto put_mem_storage(const mem_storage_t& storage) const //
+        -> int;
+    /*! configures all storages again on the connected router, unless they already are */
+    auto restore_mem_storages() //
+        -> void;
+
+    /*! watches the connection to the router through the monitor of the session, which is shared
+     * with all clients using the session */
+    auto start_monitor() //
+        -> void;
+    auto stop_monitor() //
+        -> void;
+    auto on_health_change(bool online) //
+        -> void;
 
-    std::string _host;
-    std::uint16_t _port;
-    z_owned_session_t _z_session;
+    std::set<mem_storage_t> _mem_storages;
+    /*! guards _mem_storages, which are restored by the monitor */
+    std::mutex _mem_storages_mutex;
+    std::map<std::string, std::unique_ptr<local_storage_t>> _local_storages;
+
+    connect_options_t _connect_options;
+    session_ptr_t _z_session;
+    /*! additional sessions of a sharded client, publishing only */
+    std::vector<session_ptr_t> _shards;
+    /*! held exclusively while _z_session and _shards are replaced, shared while they are used
+     * from threads other than the one connecting */
+    mutable std::shared_mutex _session_mutex;
+    /*! delivers the batches of all batched subscriptions, so it has to outlive them */
+    batch_flusher_t _batch_flusher;
     std::map<std::string, subscribe_ctx_t> _subscriptions;
+    std::map<std::string, serve_ctx_t> _queryables;
+    std::unique_ptr<outbox_t> _outbox;
+    session_monitor_t* _monitor;
+    executor_t _executor;
+    mutable resume_thread_t _resume_thread;
+
+    struct queued_publish_t
+    {
+        std::string topic;
+        z_owned_encoding_t encoding;
+        z_owned_bytes_t value;
+        /*! time of publishing in nanoseconds since the Unix epoch */
+        std::uint64_t timestamp;
+    };
+
+    std::atomic<connection_state_t> _state;
+    state_cbk_t _state_cbk;
+    std::thread _connector;
+    /*! guarded by _connect_mutex, as is the transition from connecting to connected */
+    bool _connect_stop;
+    mutable std::deque<queued_publish_t> _queued_publishes;
+    std::condition_variable _connect_cv;
+    mutable std::mutex _connect_mutex;
 };
 
 auto to_string(const z_loaned_encoding_t* encoding) //
     -> std::string;
 
+auto to_variable(const z_loaned_sample_t* sample) //
+    -> variable_t;
+
+/*! Converts sample into a variable viewing buffers. Once buffers have grown to the size of the
+ * received samples, no further allocations are made. Without payload, the value is left empty. */
+auto to_variable(const z_loaned_sample_t* sample, sample_buffers_t& buffers, bool payload = true) //
+    -> variable_t;
+
 auto ntp64_to_unix_time(std::uint64_t ntp_time) //
     -> uint64_t;
 
+auto unix_time_to_ntp64(std::uint64_t unix_time) //
+    -> uint64_t;
+
 } // namespace impl
 } // namespace flunder
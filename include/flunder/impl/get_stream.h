@@ -0,0 +1,92 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <zenoh.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "flunder/impl/client.h"
+
+namespace flunder {
+namespace impl {
+
+/*! Pulls replies of a query from a bounded FIFO channel, converting one reply at a time into
+ * reusable buffers. Ordered streams have to see all replies before delivering the first one; they
+ * keep owned copies, bounded by the limit if one is set. */
+class get_stream_t
+{
+public:
+    get_stream_t();
+    ~get_stream_t();
+
+    get_stream_t(const get_stream_t&) = delete;
+    get_stream_t& operator=(const get_stream_t&) = delete;
+
+    /*! returns the handler replies are delivered to, replacing any previous query. A limit of 0
+     * delivers all replies; keys_only skips copying payloads. */
+    auto open(
+        std::size_t depth, std::size_t limit = 0, bool ordered = false, bool keys_only = false) //
+        -> z_owned_closure_reply_t;
+
+    auto is_open() const noexcept //
+        -> bool;
+
+    auto next() //
+        -> const variable_t*;
+
+    /*! like next, but hands out the next reply itself instead of converting it. The reply is
+     * always ok; ordering is not applied. */
+    auto next_reply(z_owned_reply_t& reply) //
+        -> bool;
+
+    auto cancel() //
+        -> void;
+
+    /*! true if the query timed out before all replies were received */
+    auto timed_out() const noexcept //
+        -> bool;
+
+private:
+    using timed_variable_t = std::pair<std::uint64_t, variable_t>;
+
+    /*! receives the next reply into _current */
+    auto receive() //
+        -> bool;
+    /*! receives the next ok reply, skipping admin space replies and errors */
+    auto receive_reply(z_owned_reply_t& reply) //
+        -> bool;
+
+    /*! drains all replies into _sorted, keeping the _limit oldest ones */
+    auto sort() //
+        -> void;
+
+    z_owned_fifo_handler_reply_t _handler;
+    sample_buffers_t _buffers;
+    variable_t _current;
+
+    std::size_t _limit;
+    std::size_t _delivered;
+    bool _ordered;
+    bool _keys_only;
+    bool _sorted_ready;
+    bool _timed_out;
+    std::vector<timed_variable_t> _sorted;
+};
+
+} // namespace impl
+} // namespace flunder
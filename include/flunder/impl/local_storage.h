@@ -0,0 +1,71 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <zenoh.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "flunder/impl/segment_store.h"
+
+namespace flunder {
+namespace impl {
+
+/*! Records all samples matching a key expression into a segment_store_t and answers gets for it,
+ * either with the latest value of each key or, for queries carrying a _time parameter, with all
+ * values in the requested time range. */
+class local_storage_t
+{
+public:
+    local_storage_t(std::string key_expr, local_storage_options_t options);
+    ~local_storage_t();
+
+    local_storage_t(const local_storage_t&) = delete;
+    local_storage_t& operator=(const local_storage_t&) = delete;
+
+    /*! opens the store on first use and declares subscriber and queryable on session */
+    auto declare(const z_owned_session_t* session) //
+        -> int;
+
+    auto undeclare() //
+        -> void;
+
+private:
+    static auto on_sample(z_loaned_sample_t* sample, void* arg) //
+        -> void;
+    static auto on_query(z_loaned_query_t* query, void* arg) //
+        -> void;
+
+    std::string _key_expr;
+    segment_store_t _store;
+    bool _open;
+    const z_owned_session_t* _session;
+    z_owned_subscriber_t _sub;
+    z_owned_queryable_t _queryable;
+};
+
+/*! Parses the _time parameter of a selector into a range of nanoseconds since the Unix epoch.
+ * Supports bounds given as RFC 3339 UTC time or relative to now(), e.g. "[now(-5m)..]", either
+ * inclusive ("[start..end]") or exclusive ("]start..end["); the returned range is inclusive.
+ * Returns std::nullopt if parameters hold no valid _time. */
+auto parse_time_range(std::string_view parameters) //
+    -> std::optional<std::pair<std::uint64_t, std::uint64_t>>;
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,137 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "flunder/client.h"
+
+namespace flunder {
+namespace impl {
+
+/*! Durable FIFO of samples that could not be published, in a single memory-mapped ring file.
+ *
+ * Records use the layout of segment_store_t and are protected by a CRC32. The file header holds
+ * the offsets of the oldest and the next record, so samples buffered before a restart are replayed
+ * afterwards; on open, the ring is cut at the first corrupt record. Once the file is full, the
+ * oldest records are discarded to make room.
+ *
+ * A replay thread periodically writes the file to disk and, between start() and stop(), checks
+ * whether the router is reachable and then publishes buffered records in order at no more than
+ * replay_rate per second.
+ */
+class outbox_t
+{
+public:
+    /*! publishes a buffered sample, timestamp in nanoseconds since the Unix epoch */
+    using publish_t = std::function<int(
+        std::string_view key,
+        std::string_view value,
+        std::string_view encoding,
+        std::uint64_t timestamp)>;
+    /*! returns whether a router is reachable */
+    using online_t = std::function<bool()>;
+
+    explicit outbox_t(outbox_options_t options);
+    ~outbox_t();
+
+    outbox_t(const outbox_t&) = delete;
+    outbox_t& operator=(const outbox_t&) = delete;
+
+    /*! opens or creates options.path, recovering buffered records */
+    auto open() //
+        -> int;
+
+    /*! buffers a sample, discarding the oldest records if necessary */
+    auto append(
+        std::string_view key,
+        std::string_view value,
+        std::string_view encoding,
+        std::uint64_t timestamp) //
+        -> int;
+
+    /*! whether publishes have to be buffered to keep their order, i.e. while the router is not
+     * reachable or older samples are still waiting for replay */
+    auto is_buffering() const noexcept //
+        -> bool;
+
+    /*! replays through publish while online returns true */
+    auto start(publish_t publish, online_t online) //
+        -> void;
+    /*! stops replaying and returns once publish is no longer called; must be called before the
+     * session publish refers to is closed */
+    auto stop() //
+        -> void;
+
+    auto stats() const //
+        -> outbox_stats_t;
+
+private:
+    struct record_t
+    {
+        std::uint64_t seqno;
+        std::string key;
+        std::string value;
+        std::string encoding;
+        std::uint64_t timestamp;
+    };
+
+    auto recover() //
+        -> void;
+    /*! copies the oldest record into record; returns false if the outbox is empty */
+    auto front(record_t& record) const //
+        -> bool;
+    /*! removes the oldest record if it is still the one numbered seqno */
+    auto pop(std::uint64_t seqno) //
+        -> void;
+    auto drop_oldest() //
+        -> void;
+    auto replay() //
+        -> void;
+
+    outbox_options_t _options;
+    int _fd;
+    char* _base;
+    std::size_t _capacity;
+    /*! sequence number of the oldest record, counted since open */
+    std::uint64_t _head_seqno;
+
+    std::atomic<bool> _online;
+    std::atomic<std::uint64_t> _pending;
+    std::atomic<std::uint64_t> _buffered;
+    std::atomic<std::uint64_t> _replayed;
+    std::atomic<std::uint64_t> _discarded;
+
+    /*! guarded by _replay_mutex, which the replay thread holds while publishing */
+    publish_t _publish;
+    online_t _is_online;
+    bool _stop;
+    std::thread _thread;
+    std::condition_variable _cv;
+    std::mutex _replay_mutex;
+    /*! guards the mapped file */
+    mutable std::mutex _mutex;
+};
+
+} // namespace impl
+} // namespace flunder
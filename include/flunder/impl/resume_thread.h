@@ -0,0 +1,61 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace flunder {
+namespace impl {
+
+/*! Resumes coroutines in the order they are posted, on a thread of its own that is started with
+ * the first one. Used for clients without an executor, so coroutines never run inside zenoh
+ * callbacks. Coroutines still pending on destruction are resumed before it returns.
+ */
+class resume_thread_t
+{
+public:
+    resume_thread_t();
+    ~resume_thread_t();
+
+    resume_thread_t(const resume_thread_t&) = delete;
+    resume_thread_t& operator=(const resume_thread_t&) = delete;
+
+    auto post(std::coroutine_handle<> handle) //
+        -> void;
+
+private:
+    /*! shared with the thread, which may outlive this if a coroutine destroys the client */
+    struct queue_t
+    {
+        std::deque<std::coroutine_handle<>> handles;
+        bool stop = false;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    static auto run(std::shared_ptr<queue_t> queue) //
+        -> void;
+
+    std::shared_ptr<queue_t> _queue;
+    std::thread _thread;
+};
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,182 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "flunder/client.h"
+
+namespace flunder {
+namespace impl {
+
+//  record, padded to a multiple of 8 bytes; a size of 0 terminates the segment
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | size                              | crc32 of timestamp .. value       |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | timestamp                                                             |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | key_len         | encoding_len    | value_len                         |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | key | encoding | value | padding                                      |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+struct record_header_t
+{
+    std::uint32_t size;
+    std::uint32_t crc;
+    std::uint64_t timestamp;
+    std::uint16_t key_len;
+    std::uint16_t encoding_len;
+    std::uint32_t value_len;
+};
+
+constexpr auto RECORD_ALIGN = std::size_t{8};
+constexpr auto RECORD_CRC_OFFSET = offsetof(record_header_t, timestamp);
+
+/*! CRC-32 (IEEE 802.3) of data, protecting records written to disk */
+auto crc32(const char* data, std::size_t len) //
+    -> std::uint32_t;
+
+/*! size of a record including padding */
+auto record_size(std::size_t key_len, std::size_t encoding_len, std::size_t value_len) //
+    -> std::size_t;
+
+/*! Append-only record log in fixed-size, memory-mapped segment files.
+ *
+ * Every record carries its key, encoding, value and timestamp, protected by a CRC32. On open,
+ * segments are scanned and the log is cut at the first incomplete or corrupt record, so records
+ * torn by a power loss are discarded while everything before stays readable. An in-memory index
+ * maps every key to its records ordered by timestamp.
+ *
+ * Retention drops whole segments, oldest first. When the size limit is exceeded, records that are
+ * still the latest value of their key are carried forward into the active segment before their
+ * segment is dropped, so each record is rewritten at most once per retention pass; records expired
+ * by age are dropped unconditionally.
+ */
+class segment_store_t
+{
+public:
+    explicit segment_store_t(local_storage_options_t options);
+    ~segment_store_t();
+
+    segment_store_t(const segment_store_t&) = delete;
+    segment_store_t& operator=(const segment_store_t&) = delete;
+
+    /*! opens or creates the store below options.path, recovering existing segments */
+    auto open() //
+        -> int;
+
+    /*! appends a record, timestamp in nanoseconds since the Unix epoch */
+    auto append(
+        std::string_view key,
+        std::string_view value,
+        std::string_view encoding,
+        std::uint64_t timestamp) //
+        -> int;
+
+    /*! receives records as non-owning variables, valid for the duration of the call */
+    using visit_t = std::function<void(const variable_t&)>;
+    /*! selects the keys visited */
+    using match_t = std::function<bool(std::string_view key)>;
+
+    /*! visits the latest record of every matching key */
+    auto latest(const match_t& match, const visit_t& visit) //
+        -> void;
+
+    /*! visits all records of matching keys with timestamps in [start, end] */
+    auto range(
+        const match_t& match, std::uint64_t start, std::uint64_t end, const visit_t& visit) //
+        -> void;
+
+    /*! writes all appended records to disk */
+    auto sync() //
+        -> int;
+
+    /*! bytes occupied by all segments */
+    auto size() const //
+        -> std::size_t;
+
+private:
+    struct segment_t
+    {
+        std::uint64_t seqno;
+        int fd;
+        char* base;
+        std::size_t capacity;
+        std::size_t end;
+        std::size_t synced;
+        std::uint64_t last_timestamp;
+    };
+
+    struct record_ref_t
+    {
+        std::uint64_t seqno;
+        std::uint32_t offset;
+        std::uint64_t timestamp;
+    };
+
+    auto map_segment(std::uint64_t seqno, bool create) //
+        -> int;
+    auto recover(segment_t& segment) //
+        -> void;
+    auto do_append(
+        std::string_view key,
+        std::string_view value,
+        std::string_view encoding,
+        std::uint64_t timestamp) //
+        -> int;
+    auto roll() //
+        -> int;
+    auto enforce_retention() //
+        -> void;
+    auto drop_oldest(bool carry_forward) //
+        -> void;
+    auto sync_segment(segment_t& segment) //
+        -> int;
+    auto index(std::string_view key, record_ref_t ref) //
+        -> void;
+    /*! returns a variable viewing the segment, with its timestamp formatted into timestamp */
+    auto read(const record_ref_t& ref, std::string& timestamp) const //
+        -> variable_t;
+    auto path_of(std::uint64_t seqno) const //
+        -> std::string;
+
+    struct key_hash_t
+    {
+        using is_transparent = void;
+        auto operator()(std::string_view key) const noexcept //
+            -> std::size_t
+        {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    local_storage_options_t _options;
+    std::deque<segment_t> _segments;
+    std::unordered_map<std::string, std::vector<record_ref_t>, key_hash_t, std::equal_to<>> _index;
+    std::chrono::steady_clock::time_point _last_sync;
+    mutable std::mutex _mutex;
+};
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,124 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "flunder/aggregate.h"
+#include "flunder/history.h"
+
+namespace flunder {
+namespace impl {
+
+/*! Append-only bit stream, most significant bit first */
+class bit_writer_t
+{
+public:
+    bit_writer_t();
+
+    auto write(std::uint64_t bits, unsigned count) //
+        -> void;
+
+    auto words() const noexcept //
+        -> const std::vector<std::uint64_t>&;
+    auto size() const noexcept //
+        -> std::size_t;
+
+    auto shrink_to_fit() //
+        -> void;
+
+private:
+    std::vector<std::uint64_t> _words;
+    std::size_t _size;
+};
+
+class bit_reader_t
+{
+public:
+    explicit bit_reader_t(const std::vector<std::uint64_t>& words);
+
+    auto read(unsigned count) //
+        -> std::uint64_t;
+    auto read_bit() //
+        -> bool;
+
+private:
+    const std::uint64_t* _words;
+    std::size_t _pos;
+};
+
+/*! Gorilla-compressed samples of a single topic, split into blocks of at most block_size samples
+ * within an aligned 15 min window. Each block starts with an uncompressed sample, so blocks
+ * decode independently. */
+class series_t
+{
+public:
+    explicit series_t(std::size_t block_size);
+
+    /*! returns -1 if sample is older than the newest sample */
+    auto append(sample_t sample) //
+        -> int;
+
+    /*! drops blocks whose newest sample is older than timestamp */
+    auto expire(std::int64_t timestamp) //
+        -> void;
+
+    auto scan(std::int64_t start, std::int64_t end, const history_t::scan_cbk_t& cbk) const //
+        -> void;
+
+    /*! pushes samples with timestamps in [start, end] into aggregator. Blocks entirely within
+     * [start, end] and a single bucket are merged from their summary without decoding. */
+    auto aggregate(std::int64_t start, std::int64_t end, aggregator_t& aggregator) const //
+        -> void;
+
+    auto size() const noexcept //
+        -> std::size_t;
+    auto memory_usage() const noexcept //
+        -> std::size_t;
+    auto newest() const noexcept //
+        -> std::int64_t;
+
+private:
+    struct block_t
+    {
+        bit_writer_t bits;
+        std::size_t count;
+        std::int64_t first_timestamp;
+        std::int64_t last_timestamp;
+        std::int64_t last_delta;
+        std::uint64_t last_value;
+        unsigned leading;
+        unsigned trailing;
+        /*! min, max, sum, first and last value of all samples in the block */
+        bucket_t summary;
+    };
+
+    auto encode_timestamp(block_t& block, std::int64_t timestamp) //
+        -> void;
+    auto encode_value(block_t& block, std::uint64_t value) //
+        -> void;
+    auto decode(const block_t& block, std::vector<sample_t>& samples) const //
+        -> void;
+
+    std::size_t _block_size;
+    std::deque<block_t> _blocks;
+    std::size_t _size;
+};
+
+} // namespace impl
+} // namespace flunder
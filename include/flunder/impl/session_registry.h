@@ -0,0 +1,127 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <zenoh.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flunder {
+namespace impl {
+
+/*! zenoh session closed once the last client referring to it lets go */
+using session_ptr_t = std::shared_ptr<z_owned_session_t>;
+
+/*! number of routers and peers the session is connected to */
+auto connected_router_count(const z_owned_session_t& session) //
+    -> int;
+auto connected_peer_count(const z_owned_session_t& session) //
+    -> int;
+
+/*! Watches the connection of a session every interval on a single thread, however many clients
+ * use the session. Watchers are told when the session goes offline and when it is back online.
+ */
+class session_monitor_t
+{
+public:
+    using watch_cbk_t = std::function<void(bool online)>;
+
+    /*! a session counts as online while connected to a router or, with peer set, to a peer */
+    session_monitor_t(
+        const z_owned_session_t* session, bool peer, std::chrono::milliseconds interval);
+    ~session_monitor_t();
+
+    /*! registers cbk for watcher, starting the thread with the first watcher. cbk is invoked
+     * right away if the session is already offline. */
+    auto watch(const void* watcher, watch_cbk_t cbk) //
+        -> void;
+    /*! removes watcher; once this returns, its cbk is not invoked anymore. Returns right away if
+     * called from a cbk, which is not invoked again either. */
+    auto unwatch(const void* watcher) //
+        -> void;
+    /*! stops the thread; called before the session is closed */
+    auto stop() //
+        -> void;
+
+private:
+    auto run() //
+        -> void;
+    auto is_online() const //
+        -> bool;
+
+    const z_owned_session_t* _session;
+    bool _peer;
+    std::chrono::milliseconds _interval;
+    /*! shared with run(), which invokes them without holding _mutex */
+    std::map<const void*, std::shared_ptr<watch_cbk_t>> _watchers;
+    /*! watcher whose cbk the thread is invoking, if any */
+    const void* _current;
+    bool _online;
+    bool _stop;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::thread _thread;
+};
+
+/*! takes ownership of an open session */
+auto make_session(z_owned_session_t session) //
+    -> session_ptr_t;
+/*! takes ownership of an open session, watched by a session_monitor_t until it is closed */
+auto make_session(z_owned_session_t session, bool peer, std::chrono::milliseconds interval) //
+    -> session_ptr_t;
+/*! monitor of a session, or nullptr if it is not watched */
+auto session_monitor(const session_ptr_t& session) //
+    -> session_monitor_t*;
+
+/*! Process-wide registry of sessions shared between clients, keyed by their configuration.
+ *
+ * Only weak references are kept, so a session is closed as soon as no client uses it anymore
+ * and opened again by the next client asking for it.
+ */
+class session_registry_t
+{
+public:
+    using open_t = std::function<session_ptr_t()>;
+
+    static auto instance() //
+        -> session_registry_t&;
+
+    /*! returns the session registered for key, or registers one opened through open; returns
+     * nullptr if opening fails. The session, including its monitor, is shared as it was opened
+     * by the first client. */
+    auto acquire(const std::string& key, const open_t& open) //
+        -> session_ptr_t;
+
+    /*! number of sessions currently open through the registry */
+    auto size() const //
+        -> std::size_t;
+
+private:
+    session_registry_t() = default;
+
+    std::map<std::string, std::weak_ptr<z_owned_session_t>> _sessions;
+    mutable std::mutex _mutex;
+};
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,178 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/* Structured JSON payloads. Header-only, as it requires nlohmann_json on the include path, which
+ * the flunder libraries do not expose. */
+
+#include <nlohmann/json.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <tuple>
+
+#include "flunder/client.h"
+
+namespace flunder {
+
+/*! Serialization of JSON documents on the wire */
+enum class json_format_t {
+    /*! JSON text, "application/json" */
+    text,
+    /*! CBOR (RFC 8949), "application/cbor" */
+    cbor,
+    /*! MessagePack, "application/msgpack" */
+    msgpack,
+};
+
+constexpr auto json_encoding(json_format_t format) noexcept //
+    -> std::string_view
+{
+    switch (format) {
+        case json_format_t::cbor:
+            return "application/cbor";
+        case json_format_t::msgpack:
+            return "application/msgpack";
+        case json_format_t::text:
+        default:
+            return "application/json";
+    }
+}
+
+/*! format of a variable holding a JSON document, if it does. Encodings zenoh does not know are
+ * reported with a "zenoh/bytes;" prefix by receivers, so these are matched by their schema */
+inline auto json_format(std::string_view encoding) noexcept //
+    -> std::optional<json_format_t>
+{
+    for (const auto format : {json_format_t::text, json_format_t::cbor, json_format_t::msgpack}) {
+        const auto expected = json_encoding(format);
+        if (encoding == expected ||
+            (encoding.ends_with(expected) &&
+             encoding[encoding.size() - expected.size() - 1] == ';')) {
+            return format;
+        }
+    }
+    return std::nullopt;
+}
+
+/*! serializes doc in format and publishes it with the matching encoding */
+inline auto publish_json(
+    const client_t& client,
+    std::string_view topic,
+    const nlohmann::json& doc,
+    json_format_t format = json_format_t::cbor) //
+    -> int
+{
+    const auto encoding = json_encoding(format);
+    switch (format) {
+        case json_format_t::cbor: {
+            const auto bytes = nlohmann::json::to_cbor(doc);
+            return client.publish(topic, bytes.data(), bytes.size(), encoding);
+        }
+        case json_format_t::msgpack: {
+            const auto bytes = nlohmann::json::to_msgpack(doc);
+            return client.publish(topic, bytes.data(), bytes.size(), encoding);
+        }
+        case json_format_t::text:
+        default: {
+            const auto text = doc.dump();
+            return client.publish(topic, text.data(), text.size(), encoding);
+        }
+    }
+}
+
+/*! parses value, serialized in format. Returns a discarded document if value is malformed */
+inline auto parse_json(std::string_view value, json_format_t format) //
+    -> nlohmann::json
+{
+    const auto* begin = reinterpret_cast<const std::uint8_t*>(value.data());
+    const auto* end = begin + value.size();
+    switch (format) {
+        case json_format_t::cbor:
+            return nlohmann::json::from_cbor(begin, end, true, false);
+        case json_format_t::msgpack:
+            return nlohmann::json::from_msgpack(begin, end, true, false);
+        case json_format_t::text:
+        default:
+            return nlohmann::json::parse(value.begin(), value.end(), nullptr, false);
+    }
+}
+
+/*! @brief JSON document of a variable, parsed on first access
+ *
+ * Views the value of the variable, which has to outlive the view. Accessing a view of a variable
+ * without a JSON encoding, or with a malformed value, yields nullptr.
+ */
+class json_view_t
+{
+public:
+    explicit json_view_t(const variable_t& var)
+        : _value{var.value()}
+        , _format{json_format(var.encoding())}
+        , _doc{}
+        , _parsed{}
+    {}
+
+    auto format() const noexcept //
+        -> std::optional<json_format_t>
+    {
+        return _format;
+    }
+
+    auto get() const //
+        -> const nlohmann::json*
+    {
+        if (!_format.has_value()) {
+            return nullptr;
+        }
+        if (!_parsed) {
+            _doc = parse_json(_value, *_format);
+            _parsed = true;
+        }
+        return _doc.is_discarded() ? nullptr : &_doc;
+    }
+
+private:
+    std::string_view _value;
+    std::optional<json_format_t> _format;
+    mutable nlohmann::json _doc;
+    mutable bool _parsed;
+};
+
+inline auto as_json(const variable_t& var) //
+    -> json_view_t
+{
+    return json_view_t{var};
+}
+
+/*! parses the JSON document of var right away. Returns -ENOTSUP if var has no JSON encoding and
+ * -EINVAL if its value is malformed */
+inline auto try_as_json(const variable_t& var) //
+    -> std::tuple<int, nlohmann::json>
+{
+    const auto format = json_format(var.encoding());
+    if (!format.has_value()) {
+        return {-ENOTSUP, nullptr};
+    }
+    auto doc = parse_json(var.value(), *format);
+    if (doc.is_discarded()) {
+        return {-EINVAL, nullptr};
+    }
+    return {0, std::move(doc)};
+}
+
+} // namespace flunder
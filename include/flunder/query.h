@@ -0,0 +1,132 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace flunder {
+
+/*! Selector parameter asking queryables to reply with empty payloads */
+constexpr const char* FLUNDER_KEYS_ONLY_PARAM = "flunder_keys_only";
+
+/*! Queryables a get is routed to */
+enum class query_target_t {
+    /*! the best matching queryable, e.g. the nearest complete storage */
+    best_matching,
+    /*! all matching queryables */
+    all,
+    /*! all matching queryables declared as complete for the key expression */
+    all_complete,
+};
+
+/*! Handling of multiple replies for the same key */
+enum class consolidation_t {
+    /*! let zenoh decide: latest, unless a time range is requested */
+    automatic,
+    /*! deliver all replies, including duplicates from overlapping storages */
+    none,
+    /*! deliver replies in order, dropping those older than one already delivered */
+    monotonic,
+    /*! deliver only the latest reply per key once the query completed */
+    latest,
+};
+
+/*! @brief Selector of a get, built fluently
+ *
+ * query_t{"flecs/trend/temperature"}.since(std::chrono::minutes{5}).ordered().limit(100)
+ *
+ * Time ranges and custom parameters are passed to the queried storages as selector parameters.
+ * Ordering and limits are applied by the client while streaming the replies.
+ */
+class query_t
+{
+public:
+    using clock_t = std::chrono::system_clock;
+
+    FLECS_EXPORT explicit query_t(std::string_view topic);
+
+    /*! restrict to samples with timestamps in [start, end] (_time=[start..end]) */
+    FLECS_EXPORT auto time_range(clock_t::time_point start, clock_t::time_point end) //
+        -> query_t&;
+    /*! restrict to samples newer than the given duration (_time=[now(-duration)..]) */
+    FLECS_EXPORT auto since(clock_t::duration duration) //
+        -> query_t&;
+    /*! restrict to a raw zenoh time expression, e.g. "[now(-1h)..now(-30m)]" */
+    FLECS_EXPORT auto time_range(std::string_view expr) //
+        -> query_t&;
+
+    /*! deliver at most n results; with ordered(), the n oldest ones */
+    FLECS_EXPORT auto limit(std::size_t n) //
+        -> query_t&;
+    /*! deliver results in ascending timestamp order */
+    FLECS_EXPORT auto ordered(bool ordered = true) //
+        -> query_t&;
+    /*! deliver keys, encodings and timestamps only, replacing a FLUNDER_KEYS_ONLY_PARAM set
+     * through param(). Only flunder queryables, i.e. serve() and local storages, honour it and
+     * reply without payloads. Storages of the router ignore it and still send payloads, which
+     * are then not copied; the transfer is not reduced. */
+    FLECS_EXPORT auto keys_only(bool keys_only = true) //
+        -> query_t&;
+
+    /*! select the queryables the query is routed to (default: all) */
+    FLECS_EXPORT auto target(query_target_t target) //
+        -> query_t&;
+    /*! select how replies for the same key are consolidated (default: automatic) */
+    FLECS_EXPORT auto consolidation(consolidation_t consolidation) //
+        -> query_t&;
+    /*! finish the query after timeout, delivering the replies received until then. A timeout of
+     * zero uses the default timeout of the session. */
+    FLECS_EXPORT auto timeout(std::chrono::milliseconds timeout) //
+        -> query_t&;
+
+    /*! add or replace an arbitrary selector parameter */
+    FLECS_EXPORT auto param(std::string_view key, std::string_view value) //
+        -> query_t&;
+
+    FLECS_EXPORT auto topic() const noexcept //
+        -> std::string_view;
+    /*! selector parameters in zenoh syntax, i.e. key=value pairs separated by ';' */
+    FLECS_EXPORT auto parameters() const //
+        -> std::string;
+    FLECS_EXPORT auto limit() const noexcept //
+        -> std::size_t;
+    FLECS_EXPORT auto is_ordered() const noexcept //
+        -> bool;
+    FLECS_EXPORT auto is_keys_only() const noexcept //
+        -> bool;
+    FLECS_EXPORT auto target() const noexcept //
+        -> query_target_t;
+    FLECS_EXPORT auto consolidation() const noexcept //
+        -> consolidation_t;
+    FLECS_EXPORT auto timeout() const noexcept //
+        -> std::chrono::milliseconds;
+
+private:
+    std::string _topic;
+    std::vector<std::pair<std::string, std::string>> _params;
+    std::size_t _limit;
+    bool _ordered;
+    bool _keys_only;
+    query_target_t _target;
+    consolidation_t _consolidation;
+    std::chrono::milliseconds _timeout;
+};
+
+} // namespace flunder
@@ -0,0 +1,168 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "flunder/variable.h"
+
+#ifdef __cplusplus
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace flunder {
+
+namespace impl {
+class client_t;
+} // namespace impl
+
+/*! how get_result_set stores topics and values */
+enum class result_mode_t {
+    /*! copy everything into the arena */
+    copy,
+    /*! keep the replies alive and let variables borrow topics and values from them, copying only
+     * payloads that are not contiguous. Topics and values are not '\0'-terminated then */
+    zero_copy,
+};
+
+/*! @brief Variables of a query result, backed by a single arena
+ *
+ * Created through client_t::get_result_set. All strings of all variables are copied back to back
+ * into blocks of geometrically growing size, so a result allocates a handful of times regardless
+ * of the number of variables, instead of once per variable. The variables do not own their data
+ * and stay valid for the lifetime of the set; moving the set keeps them valid. Sets created with
+ * result_mode_t::zero_copy additionally hold the replies their variables borrow from.
+ */
+class result_set_t
+{
+public:
+    using const_iterator = std::vector<variable_t>::const_iterator;
+
+    FLECS_EXPORT result_set_t();
+
+    FLECS_EXPORT result_set_t(const result_set_t&) = delete;
+    FLECS_EXPORT result_set_t(result_set_t&& other) noexcept;
+
+    FLECS_EXPORT result_set_t& operator=(const result_set_t&) = delete;
+    FLECS_EXPORT result_set_t& operator=(result_set_t&& other) noexcept;
+
+    FLECS_EXPORT ~result_set_t();
+
+    /*! copies var into the arena and returns the copy */
+    FLECS_EXPORT auto push_back(const variable_t& var) //
+        -> const variable_t&;
+
+    /*! prepares for count variables with bytes of strings in total */
+    FLECS_EXPORT auto reserve(std::size_t count, std::size_t bytes) //
+        -> void;
+
+    FLECS_EXPORT auto clear() noexcept //
+        -> void;
+
+    auto size() const noexcept //
+        -> std::size_t
+    {
+        return _vars.size();
+    }
+    auto empty() const noexcept //
+        -> bool
+    {
+        return _vars.empty();
+    }
+    auto operator[](std::size_t i) const noexcept //
+        -> const variable_t&
+    {
+        return _vars[i];
+    }
+    auto begin() const noexcept //
+        -> const_iterator
+    {
+        return _vars.cbegin();
+    }
+    auto end() const noexcept //
+        -> const_iterator
+    {
+        return _vars.cend();
+    }
+    auto vars() const noexcept //
+        -> std::span<const variable_t>
+    {
+        return _vars;
+    }
+
+    /*! bytes allocated for variables and arena blocks */
+    FLECS_EXPORT auto memory_usage() const noexcept //
+        -> std::size_t;
+
+private:
+    friend class impl::client_t;
+
+    FLECS_EXPORT friend auto swap(result_set_t& lhs, result_set_t& rhs) noexcept //
+        -> void;
+
+    using owner_t = std::unique_ptr<void, void (*)(void*)>;
+
+    /*! keeps owner alive as long as the set, for variables borrowing from it */
+    auto retain(owner_t owner) //
+        -> void;
+    /*! borrows topic and value, copies encoding and timestamp into the arena */
+    auto push_back_borrowed(
+        std::string_view topic,
+        std::string_view value,
+        std::string_view encoding,
+        std::string_view timestamp) //
+        -> const variable_t&;
+
+    /*! copies str into the arena, terminated by '\0' */
+    auto store(std::string_view str) //
+        -> std::string_view;
+    auto allocate(std::size_t size) //
+        -> char*;
+
+    std::vector<variable_t> _vars;
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    std::size_t _block_size;
+    char* _pos;
+    std::size_t _left;
+    std::size_t _allocated;
+    std::vector<owner_t> _owners;
+};
+
+} // namespace flunder
+
+#endif // __cplusplus
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** like flunder_get, but all variables share one arena and are released by a single call to
+ * flunder_result_set_destroy. *results is set even on error and holds the replies received until
+ * then if the query timed out */
+FLECS_EXPORT int flunder_get_result_set(const void* flunder, const char* topic, void** results);
+
+FLECS_EXPORT size_t flunder_result_set_size(const void* results);
+
+/** returns NULL if i is out of range; the variables are contiguous, so flunder_variable_next
+ * works as well */
+FLECS_EXPORT const variable_t* flunder_result_set_at(const void* results, size_t i);
+
+FLECS_EXPORT void flunder_result_set_destroy(void* results);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
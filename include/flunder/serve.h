@@ -0,0 +1,101 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "flunder/variable.h"
+
+#ifdef __cplusplus
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+struct z_loaned_query_t;
+struct z_owned_session_t;
+
+namespace flunder {
+
+/*! @brief Answers a get received by a queryable declared through client_t::serve
+ *
+ * Only valid for the duration of the serve callback. Every reply is timestamped by the serving
+ * session. Queries asking for keys only (see query_t::keys_only) are answered without payloads,
+ * so handlers do not have to distinguish them.
+ */
+class reply_builder_t
+{
+public:
+    FLECS_EXPORT reply_builder_t(const z_loaned_query_t* query, const z_owned_session_t* session);
+
+    /*! key expression of the query */
+    FLECS_EXPORT auto key_expr() const noexcept //
+        -> std::string_view;
+    /*! selector parameters of the query, e.g. "_time=[now(-5m)..]" */
+    FLECS_EXPORT auto parameters() const noexcept //
+        -> std::string_view;
+    FLECS_EXPORT auto is_keys_only() const noexcept //
+        -> bool;
+
+    /*! reply with a copy of value */
+    FLECS_EXPORT auto reply(
+        std::string_view key, std::string_view value, std::string_view encoding = "text/plain") //
+        -> int;
+    auto reply(std::string_view key, const char* value, std::string_view encoding = "text/plain") //
+        -> int
+    {
+        return reply(key, std::string_view{value}, encoding);
+    }
+    /*! reply with value, handing its buffer to the session without copying */
+    FLECS_EXPORT auto reply(
+        std::string_view key, std::string&& value, std::string_view encoding = "text/plain") //
+        -> int;
+    /*! reply with a caller-owned buffer without copying; release is called with data and ctx once
+     * the session no longer references it, which may be after the serve callback returned */
+    FLECS_EXPORT auto reply(
+        std::string_view key,
+        const void* data,
+        std::size_t len,
+        std::string_view encoding,
+        void (*release)(void* data, void* ctx),
+        void* ctx) //
+        -> int;
+    /*! reply with a copy of var's value and encoding under var's topic, keeping its timestamp */
+    FLECS_EXPORT auto reply(const variable_t& var) //
+        -> int;
+
+private:
+    const z_loaned_query_t* _query;
+    const z_owned_session_t* _session;
+    std::string_view _key_expr;
+    std::string_view _parameters;
+};
+
+/*! Answers a single get; invoked concurrently from zenoh threads */
+using serve_cbk_t = std::function<void(reply_builder_t&)>;
+
+} // namespace flunder
+
+extern "C" {
+#endif // __cplusplus
+
+typedef void (*flunder_serve_cbk_t)(void* reply, void* userp);
+
+/** reply to a query received through flunder_serve with a copy of data */
+FLECS_EXPORT int flunder_reply(
+    void* reply, const char* key, const void* data, size_t len, const char* encoding);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
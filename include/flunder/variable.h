@@ -16,13 +16,21 @@
 
 #ifdef __cplusplus
 
+#include <cstdint>
 #include <cstdlib>
 #include <string>
 #include <string_view>
-#include <variant>
+#include <tuple>
 
 namespace flunder {
 
+/*! A sample of a topic: its value, encoding and timestamp.
+ *
+ * Variables either view memory owned by someone else, e.g. a receive buffer or a result_set_t,
+ * or own a single buffer holding all four strings back to back, each terminated by '\0'.
+ * Copies always own their data; moves keep viewing the same memory. Values may be of any size;
+ * topics, encodings and timestamps of 4 GiB or more are rejected with std::length_error.
+ */
 class variable_t
 {
 public:
@@ -32,6 +40,18 @@ public:
         std::string topic, std::string value, std::string encoding, std::string timestamp);
     FLECS_EXPORT variable_t(
         const char* topic, const char* value, const char* encoding, const char* timestamp);
+    /*! non-owning; the viewed data has to outlive the variable unless own() is called */
+    FLECS_EXPORT variable_t(
+        std::string_view topic,
+        std::string_view value,
+        std::string_view encoding,
+        std::string_view timestamp);
+
+    FLECS_EXPORT variable_t(const variable_t& other);
+    FLECS_EXPORT variable_t(variable_t&& other) noexcept;
+    FLECS_EXPORT variable_t& operator=(const variable_t& other);
+    FLECS_EXPORT variable_t& operator=(variable_t&& other) noexcept;
+    FLECS_EXPORT ~variable_t();
 
     FLECS_EXPORT auto topic() const noexcept //
         -> std::string_view;
@@ -44,16 +64,52 @@ public:
     FLECS_EXPORT auto timestamp() const noexcept //
         -> std::string_view;
 
+    /*! converts the value to T according to its encoding. Text encodings ("text/plain",
+     * "text/plain;int32", ...) are parsed, except for "text/plain;int8" and "text/plain;uint8",
+     * which hold a single raw byte. Binary ones ("application/octet-stream", "zenoh/bytes") are
+     * loaded directly if their size matches T. Returns -EINVAL if the value is no valid T,
+     * -ERANGE if it does not fit into T and -ENOTSUP for other encodings.
+     *
+     * T is bool, a fixed-width integer, float, double or std::string_view */
+    template <typename T>
+    FLECS_EXPORT auto try_as() const noexcept //
+        -> std::tuple<int, T>;
+    /*! like try_as, but returns fallback if the value cannot be converted */
+    template <typename T>
+    auto as(T fallback = T{}) const noexcept //
+        -> T
+    {
+        const auto [res, value] = try_as<T>();
+        return (res == 0) ? value : fallback;
+    }
+
     FLECS_EXPORT auto own() //
         -> void;
     FLECS_EXPORT auto is_owned() const noexcept //
         -> bool;
 
+    FLECS_EXPORT friend auto swap(variable_t& lhs, variable_t& rhs) noexcept //
+        -> void;
+
 private:
-    std::variant<std::string_view, std::string> _topic;
-    std::variant<std::string_view, std::string> _value;
-    std::variant<std::string_view, std::string> _encoding;
-    std::variant<std::string_view, std::string> _timestamp;
+    /*! copies all strings into one buffer owned by the variable */
+    auto assign(
+        std::string_view topic,
+        std::string_view value,
+        std::string_view encoding,
+        std::string_view timestamp) //
+        -> void;
+
+    /* an owned buffer starts at _topic */
+    const char* _topic;
+    const char* _value;
+    const char* _encoding;
+    const char* _timestamp;
+    std::size_t _value_len;
+    std::uint32_t _topic_len;
+    std::uint32_t _encoding_len;
+    std::uint32_t _timestamp_len;
+    bool _owned;
 };
 
 } // namespace flunder
@@ -61,6 +117,7 @@ private:
 #else // __cplusplus
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 typedef struct variable_t variable_t;
@@ -86,6 +143,21 @@ FLECS_EXPORT size_t flunder_variable_len(const variable_t* var);
 FLECS_EXPORT const char* flunder_variable_encoding(const variable_t* var);
 FLECS_EXPORT const char* flunder_variable_timestamp(const variable_t* var);
 
+/** convert the value according to its encoding. Return 0 on success, -EINVAL if the value is not
+ * of the requested type, -ERANGE if it is out of range and -ENOTSUP for unsupported encodings;
+ * *value is left untouched on error */
+FLECS_EXPORT int flunder_variable_as_bool(const variable_t* var, bool* value);
+FLECS_EXPORT int flunder_variable_as_int8(const variable_t* var, int8_t* value);
+FLECS_EXPORT int flunder_variable_as_int16(const variable_t* var, int16_t* value);
+FLECS_EXPORT int flunder_variable_as_int32(const variable_t* var, int32_t* value);
+FLECS_EXPORT int flunder_variable_as_int64(const variable_t* var, int64_t* value);
+FLECS_EXPORT int flunder_variable_as_uint8(const variable_t* var, uint8_t* value);
+FLECS_EXPORT int flunder_variable_as_uint16(const variable_t* var, uint16_t* value);
+FLECS_EXPORT int flunder_variable_as_uint32(const variable_t* var, uint32_t* value);
+FLECS_EXPORT int flunder_variable_as_uint64(const variable_t* var, uint64_t* value);
+FLECS_EXPORT int flunder_variable_as_float(const variable_t* var, float* value);
+FLECS_EXPORT int flunder_variable_as_double(const variable_t* var, double* value);
+
 FLECS_EXPORT void flunder_variable_destroy(variable_t* var);
 FLECS_EXPORT void flunder_variable_list_destroy(variable_t* vars, size_t n);
 FLECS_EXPORT const variable_t* flunder_variable_next(const variable_t* var);
@@ -0,0 +1,160 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/aggregate.h"
+
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+namespace flunder {
+
+namespace {
+
+/* reduces a run of samples within one bucket; four independent accumulators break the
+ * dependency chain of min/max/sum so the loop pipelines and vectorizes */
+auto reduce(const sample_t* first, const sample_t* last) //
+    -> bucket_t
+{
+    const auto count = static_cast<std::size_t>(last - first);
+    double min[4] = {first->value, first->value, first->value, first->value};
+    double max[4] = {first->value, first->value, first->value, first->value};
+    double sum[4] = {};
+
+    auto i = std::size_t{};
+    for (; i + 4 <= count; i += 4) {
+        for (auto lane = 0; lane < 4; ++lane) {
+            const auto value = first[i + lane].value;
+            min[lane] = value < min[lane] ? value : min[lane];
+            max[lane] = value > max[lane] ? value : max[lane];
+            sum[lane] += value;
+        }
+    }
+    for (; i < count; ++i) {
+        const auto value = first[i].value;
+        min[0] = value < min[0] ? value : min[0];
+        max[0] = value > max[0] ? value : max[0];
+        sum[0] += value;
+    }
+
+    return bucket_t{
+        0,
+        count,
+        std::min({min[0], min[1], min[2], min[3]}),
+        std::max({max[0], max[1], max[2], max[3]}),
+        (sum[0] + sum[1]) + (sum[2] + sum[3]),
+        first->value,
+        (last - 1)->value};
+}
+
+auto to_sample(const variable_t& var, sample_t& sample) //
+    -> bool
+{
+    const auto value = var.value();
+    const auto [value_end, value_ec] =
+        std::from_chars(value.data(), value.data() + value.size(), sample.value);
+    const auto timestamp = var.timestamp();
+    const auto [timestamp_end, timestamp_ec] =
+        std::from_chars(timestamp.data(), timestamp.data() + timestamp.size(), sample.timestamp);
+    return value_ec == std::errc{} && timestamp_ec == std::errc{};
+}
+
+} // namespace
+
+aggregator_t::aggregator_t(std::chrono::nanoseconds width)
+    : _width{std::max<std::int64_t>(width.count(), 1)}
+    , _buckets{}
+{}
+
+auto aggregator_t::push(std::span<const sample_t> samples) //
+    -> void
+{
+    auto first = samples.data();
+    const auto end = first + samples.size();
+    while (first != end) {
+        const auto start = bucket_start(first->timestamp);
+        /* samples are sorted, so the run of the current bucket ends at the first newer sample */
+        const auto last = std::partition_point(first, end, [&](const sample_t& sample) {
+            return sample.timestamp - start < _width;
+        });
+        auto partial = reduce(first, last);
+        partial.start = start;
+        push(partial);
+        first = last;
+    }
+}
+
+auto aggregator_t::push(const bucket_t& partial) //
+    -> void
+{
+    if (partial.count == 0) {
+        return;
+    }
+    if (_buckets.empty() || _buckets.back().start != partial.start) {
+        _buckets.push_back(partial);
+        return;
+    }
+    auto& bucket = _buckets.back();
+    bucket.count += partial.count;
+    bucket.min = std::min(bucket.min, partial.min);
+    bucket.max = std::max(bucket.max, partial.max);
+    bucket.sum += partial.sum;
+    bucket.last = partial.last;
+}
+
+auto aggregator_t::bucket_start(std::int64_t timestamp) const noexcept //
+    -> std::int64_t
+{
+    /* round towards negative infinity for timestamps before the epoch */
+    const auto rem = timestamp % _width;
+    return timestamp - ((rem < 0) ? rem + _width : rem);
+}
+
+auto aggregator_t::buckets() const noexcept //
+    -> const std::vector<bucket_t>&
+{
+    return _buckets;
+}
+
+auto aggregator_t::take() //
+    -> std::vector<bucket_t>
+{
+    return std::exchange(_buckets, {});
+}
+
+auto aggregate(std::span<const variable_t> vars, std::chrono::nanoseconds width) //
+    -> std::map<std::string, std::vector<bucket_t>, std::less<>>
+{
+    auto samples = std::map<std::string_view, std::vector<sample_t>>{};
+    for (const auto& var : vars) {
+        auto sample = sample_t{};
+        if (to_sample(var, sample)) {
+            samples[var.topic()].push_back(sample);
+        }
+    }
+
+    auto res = std::map<std::string, std::vector<bucket_t>, std::less<>>{};
+    for (auto& [topic, topic_samples] : samples) {
+        std::stable_sort(
+            topic_samples.begin(),
+            topic_samples.end(),
+            [](const sample_t& lhs, const sample_t& rhs) { return lhs.timestamp < rhs.timestamp; });
+        auto aggregator = aggregator_t{width};
+        aggregator.push(topic_samples);
+        res.emplace(std::string{topic}, aggregator.take());
+    }
+    return res;
+}
+
+} // namespace flunder
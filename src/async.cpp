@@ -0,0 +1,250 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/async.h"
+
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "flunder/client.h"
+#include "flunder/impl/client.h"
+
+namespace flunder {
+namespace impl {
+
+static auto resume(const executor_t& executor, std::coroutine_handle<> handle) //
+    -> void
+{
+    if (executor) {
+        executor(handle);
+    } else {
+        handle.resume();
+    }
+}
+
+struct stream_state_t
+{
+    auto push(const variable_t& var) //
+        -> void
+    {
+        auto lock = std::unique_lock{_mutex};
+        if (_closed) {
+            return;
+        }
+        _queue.emplace_back(var);
+        wake(lock);
+    }
+
+    auto close() //
+        -> void
+    {
+        auto lock = std::unique_lock{_mutex};
+        _closed = true;
+        wake(lock);
+    }
+
+    auto wake(std::unique_lock<std::mutex>& lock) //
+        -> void
+    {
+        if (auto handle = std::exchange(_waiter, nullptr)) {
+            lock.unlock();
+            resume(_executor, handle);
+        }
+    }
+
+    std::mutex _mutex;
+    std::deque<variable_t> _queue;
+    std::coroutine_handle<> _waiter;
+    executor_t _executor;
+    bool _closed;
+};
+
+} // namespace impl
+
+get_awaitable_t::get_awaitable_t(const client_t* client, std::string_view topic)
+    : _client{client}
+    , _topic{topic}
+    , _result{}
+{}
+
+auto get_awaitable_t::await_suspend(std::coroutine_handle<> handle) //
+    -> void
+{
+    auto executor = _client->_impl->callback_executor();
+    _client->_impl->get_async(
+        _topic,
+        [this, handle, executor = std::move(executor)](int res, std::vector<variable_t> vars) {
+            _result = {res, std::move(vars)};
+            impl::resume(executor, handle);
+        });
+}
+
+auto get_awaitable_t::await_resume() //
+    -> std::tuple<int, std::vector<variable_t>>
+{
+    return std::move(_result);
+}
+
+publish_awaitable_t::publish_awaitable_t(const client_t* client, std::function<int()> publish)
+    : _client{client}
+    , _publish{std::move(publish)}
+    , _res{-1}
+{}
+
+auto publish_awaitable_t::await_suspend(std::coroutine_handle<> handle) //
+    -> bool
+{
+    _res = _publish();
+
+    const auto& executor = _client->_impl->executor();
+    if (!executor) {
+        return false;
+    }
+    executor(handle);
+    return true;
+}
+
+auto publish_awaitable_t::await_resume() const noexcept //
+    -> int
+{
+    return _res;
+}
+
+auto subscription_stream_t::next_awaitable_t::await_ready() const noexcept //
+    -> bool
+{
+    auto lock = std::lock_guard{_state->_mutex};
+    return !_state->_queue.empty() || _state->_closed;
+}
+
+auto subscription_stream_t::next_awaitable_t::await_suspend(std::coroutine_handle<> handle) //
+    -> bool
+{
+    auto lock = std::lock_guard{_state->_mutex};
+    if (!_state->_queue.empty() || _state->_closed) {
+        return false;
+    }
+    _state->_waiter = handle;
+    return true;
+}
+
+auto subscription_stream_t::next_awaitable_t::await_resume() //
+    -> std::optional<variable_t>
+{
+    auto lock = std::lock_guard{_state->_mutex};
+    if (_state->_queue.empty()) {
+        return std::nullopt;
+    }
+    auto var = std::move(_state->_queue.front());
+    _state->_queue.pop_front();
+    return var;
+}
+
+subscription_stream_t::subscription_stream_t()
+    : _client{}
+    , _topic{}
+    , _state{}
+{}
+
+subscription_stream_t::subscription_stream_t(subscription_stream_t&& other) noexcept
+    : subscription_stream_t{}
+{
+    swap(*this, other);
+}
+
+subscription_stream_t& subscription_stream_t::operator=(subscription_stream_t&& other) noexcept
+{
+    swap(*this, other);
+    return *this;
+}
+
+subscription_stream_t::~subscription_stream_t()
+{
+    close();
+}
+
+auto subscription_stream_t::is_open() const noexcept //
+    -> bool
+{
+    if (!_state) {
+        return false;
+    }
+    auto lock = std::lock_guard{_state->_mutex};
+    return !_state->_closed;
+}
+
+auto subscription_stream_t::next() //
+    -> next_awaitable_t
+{
+    return next_awaitable_t{_state.get()};
+}
+
+auto subscription_stream_t::close() //
+    -> void
+{
+    if (!_state) {
+        return;
+    }
+    if (_client) {
+        _client->unsubscribe(_topic);
+        _client = nullptr;
+    }
+    _state->close();
+}
+
+auto swap(subscription_stream_t& lhs, subscription_stream_t& rhs) noexcept //
+    -> void
+{
+    using std::swap;
+    swap(lhs._client, rhs._client);
+    swap(lhs._topic, rhs._topic);
+    swap(lhs._state, rhs._state);
+}
+
+auto client_t::set_executor(executor_t executor) //
+    -> void
+{
+    _impl->set_executor(std::move(executor));
+}
+
+auto client_t::async_get(std::string_view topic) const //
+    -> get_awaitable_t
+{
+    return get_awaitable_t{this, topic};
+}
+
+auto client_t::async_subscribe(std::string_view topic) //
+    -> subscription_stream_t
+{
+    auto stream = subscription_stream_t{};
+    stream._state = std::make_shared<impl::stream_state_t>();
+    stream._state->_executor = _impl->callback_executor();
+    stream._state->_closed = false;
+
+    auto state = stream._state;
+    const auto res = subscribe(topic, [state](client_t*, const variable_t* var) {
+        state->push(*var);
+    });
+    if (res != 0) {
+        stream._state->_closed = true;
+        return stream;
+    }
+
+    stream._client = this;
+    stream._topic = topic;
+    return stream;
+}
+
+} // namespace flunder
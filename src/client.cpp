@@ -14,6 +14,9 @@
 
 #include "flunder/client.h"
 
+#include <algorithm>
+#include <cerrno>
+
 #include "flunder/impl/client.h"
 #include "flunder/impl/to_bytes.h"
 #include "flunder/to_string.h"
@@ -53,12 +56,36 @@ auto client_t::connect(std::string_view host, int port) //
     return _impl->connect(host, port);
 }
 
+auto client_t::connect(connect_options_t options) //
+    -> int
+{
+    return _impl->connect(std::move(options));
+}
+
+auto client_t::connect_async(connect_options_t options, connect_cbk_t cbk) //
+    -> std::future<int>
+{
+    return _impl->connect_async(std::move(options), std::move(cbk));
+}
+
 auto client_t::is_connected() const noexcept //
     -> bool
 {
     return _impl->is_connected();
 }
 
+auto client_t::on_state_change(state_cbk_t cbk) //
+    -> void
+{
+    _impl->on_state_change(std::move(cbk));
+}
+
+auto client_t::state() const noexcept //
+    -> connection_state_t
+{
+    return _impl->state();
+}
+
 auto client_t::reconnect() //
     -> int
 {
@@ -71,6 +98,24 @@ auto client_t::disconnect() //
     return _impl->disconnect();
 }
 
+auto client_t::enable_outbox(outbox_options_t options) //
+    -> int
+{
+    return _impl->enable_outbox(std::move(options));
+}
+
+auto client_t::disable_outbox() //
+    -> int
+{
+    return _impl->disable_outbox();
+}
+
+auto client_t::outbox_stats() const //
+    -> outbox_stats_t
+{
+    return _impl->outbox_stats();
+}
+
 /* bool */
 auto client_t::publish(std::string_view topic, bool value) const //
     -> int
@@ -165,6 +210,12 @@ auto client_t::subscribe(std::string_view topic, subscribe_cbk_t cbk) //
     return _impl->subscribe(this, std::move(topic), std::move(cbk));
 }
 
+auto client_t::subscribe(std::string_view topic, subscribe_delegate_t delegate) //
+    -> int
+{
+    return _impl->subscribe(this, topic, delegate);
+}
+
 auto client_t::subscribe(
     std::string_view topic,
     subscribe_cbk_userp_t cbk,
@@ -174,12 +225,33 @@ auto client_t::subscribe(
     return _impl->subscribe(this, std::move(topic), std::move(cbk), userp);
 }
 
+auto client_t::subscribe_batch(
+    std::string_view topic,
+    subscribe_batch_cbk_t cbk,
+    batch_options_t options) //
+    -> int
+{
+    return _impl->subscribe_batch(this, topic, std::move(cbk), options);
+}
+
 auto client_t::unsubscribe(std::string_view topic) //
     -> int
 {
     return _impl->unsubscribe(topic);
 }
 
+auto client_t::serve(std::string_view key_expr, serve_cbk_t cbk) //
+    -> int
+{
+    return _impl->serve(key_expr, std::move(cbk));
+}
+
+auto client_t::unserve(std::string_view key_expr) //
+    -> int
+{
+    return _impl->unserve(key_expr);
+}
+
 auto client_t::add_mem_storage(
     std::string_view name,
     std::string_view topic) //
@@ -194,12 +266,100 @@ auto client_t::remove_mem_storage(std::string_view name) //
     return _impl->remove_mem_storage(std::string{name});
 }
 
+auto client_t::add_local_storage(
+    std::string_view name, std::string_view key_expr, local_storage_options_t options) //
+    -> int
+{
+    return _impl->add_local_storage(std::string{name}, key_expr, std::move(options));
+}
+
+auto client_t::remove_local_storage(std::string_view name) //
+    -> int
+{
+    return _impl->remove_local_storage(std::string{name});
+}
+
 auto client_t::get(std::string_view topic) const //
     -> std::tuple<int, std::vector<variable_t>>
 {
     return _impl->get(topic);
 }
 
+auto client_t::get(std::string_view topic, get_reply_cbk_t cbk, std::size_t depth) const //
+    -> int
+{
+    return get(query_t{topic}, std::move(cbk), depth);
+}
+
+auto client_t::get(const query_t& query) const //
+    -> std::tuple<int, std::vector<variable_t>>
+{
+    return _impl->get(query);
+}
+
+auto client_t::get_result_set(const query_t& query, result_mode_t mode) const //
+    -> std::tuple<int, result_set_t>
+{
+    return _impl->get_result_set(query, mode);
+}
+
+auto client_t::get_columns(const query_t& query) const //
+    -> std::tuple<int, column_set_t>
+{
+    return _impl->get_columns(query);
+}
+
+auto client_t::get(const query_t& query, get_reply_cbk_t cbk, std::size_t depth) const //
+    -> int
+{
+    auto [res, stream] = get_stream(query, depth);
+    if (res != 0) {
+        return res;
+    }
+    for (const auto& var : stream) {
+        if (!cbk(&var)) {
+            stream.cancel();
+            return 0;
+        }
+    }
+    return stream.timed_out() ? -ETIMEDOUT : 0;
+}
+
+auto client_t::get_many(
+    std::span<const std::string_view> topics,
+    std::chrono::milliseconds timeout) const //
+    -> std::tuple<int, std::vector<std::vector<variable_t>>>
+{
+    return _impl->get_many(topics, timeout);
+}
+
+auto client_t::get_stream(std::string_view topic, std::size_t depth) const //
+    -> std::tuple<int, get_stream_t>
+{
+    return get_stream(query_t{topic}, depth);
+}
+
+auto client_t::get_stream(const query_t& query, std::size_t depth) const //
+    -> std::tuple<int, get_stream_t>
+{
+    auto stream = get_stream_t{};
+    const auto res = _impl->get_stream(query, depth, *stream._impl);
+    return {res, std::move(stream)};
+}
+
+auto client_t::list_keys(std::string_view prefix) const //
+    -> std::tuple<int, std::vector<variable_t>>
+{
+    auto topic = std::string{prefix};
+    if (!topic.ends_with("**")) {
+        if (!topic.empty() && !topic.ends_with('/')) {
+            topic += '/';
+        }
+        topic += "**";
+    }
+    return get(query_t{topic}.keys_only());
+}
+
 auto client_t::erase(std::string_view topic) //
     -> int
 {
@@ -230,6 +390,35 @@ FLECS_EXPORT int flunder_connect(void* flunder, const char* host, int port)
     return static_cast<flunder::client_t*>(flunder)->connect(host, port);
 }
 
+FLECS_EXPORT int flunder_connect_options(void* flunder, const flunder_connect_options_t* options)
+{
+    auto opt = connect_options_t{};
+    opt.endpoints.assign(options->endpoints, options->endpoints + options->endpoints_len);
+    opt.listen.assign(options->listen, options->listen + options->listen_len);
+    opt.mode = (options->mode == FLUNDER_MODE_PEER) ? session_mode_t::peer : session_mode_t::client;
+    opt.scouting = options->scouting;
+    switch (options->profile) {
+        case FLUNDER_PROFILE_LOW_LATENCY:
+            opt.profile = transport_profile_t::low_latency;
+            break;
+        case FLUNDER_PROFILE_HIGH_THROUGHPUT:
+            opt.profile = transport_profile_t::high_throughput;
+            break;
+        case FLUNDER_PROFILE_CONSTRAINED_MEMORY:
+            opt.profile = transport_profile_t::constrained_memory;
+            break;
+        default:
+            opt.profile = transport_profile_t::balanced;
+            break;
+    }
+    for (auto i = std::size_t{}; i < options->config_len; ++i) {
+        opt.config[options->config_keys[i]] = options->config_values[i];
+    }
+    opt.shared_session = options->shared_session;
+    opt.shards = std::max<std::size_t>(options->shards, 1);
+    return static_cast<flunder::client_t*>(flunder)->connect(std::move(opt));
+}
+
 FLECS_EXPORT int flunder_is_connected(const void* flunder)
 {
     return static_cast<const flunder::client_t*>(flunder)->is_connected();
@@ -257,17 +446,43 @@ FLECS_EXPORT int flunder_subscribe_userp(
     return static_cast<flunder::client_t*>(flunder)->subscribe(topic, p, userp);
 }
 
+FLECS_EXPORT int flunder_subscribe_batch(
+    void* flunder,
+    const char* topic,
+    flunder_subscribe_batch_cbk_t cbk,
+    size_t max_items,
+    uint64_t max_delay_us,
+    const void* userp)
+{
+    auto p = [cbk, userp](client_t* client, std::span<const variable_t> vars) {
+        cbk(client, vars.data(), vars.size(), const_cast<void*>(userp));
+    };
+    const auto options = batch_options_t{max_items, std::chrono::microseconds{max_delay_us}};
+    return static_cast<flunder::client_t*>(flunder)->subscribe_batch(topic, p, options);
+}
+
 FLECS_EXPORT int flunder_unsubscribe(void* flunder, const char* topic)
 {
     return static_cast<flunder::client_t*>(flunder)->unsubscribe(topic);
 }
 
-FLECS_EXPORT int flunder_get(const void* flunder, const char* topic, variable_t** vars, size_t* n)
+FLECS_EXPORT int flunder_serve(
+    void* flunder, const char* key_expr, flunder_serve_cbk_t cbk, void* userp)
 {
-    *n = 0;
-    *vars = nullptr;
+    return static_cast<flunder::client_t*>(flunder)->serve(
+        key_expr,
+        [cbk, userp](flunder::reply_builder_t& reply) { cbk(static_cast<void*>(&reply), userp); });
+}
+
+FLECS_EXPORT int flunder_unserve(void* flunder, const char* key_expr)
+{
+    return static_cast<flunder::client_t*>(flunder)->unserve(key_expr);
+}
 
-    auto [res, v] = static_cast<const flunder::client_t*>(flunder)->get(topic);
+static int to_variable_list(
+    std::tuple<int, std::vector<flunder::variable_t>> result, variable_t** vars, size_t* n)
+{
+    auto& [res, v] = result;
     if (v.empty()) {
         return res;
     }
@@ -281,6 +496,24 @@ FLECS_EXPORT int flunder_get(const void* flunder, const char* topic, variable_t*
     return res;
 }
 
+FLECS_EXPORT int flunder_get(const void* flunder, const char* topic, variable_t** vars, size_t* n)
+{
+    *n = 0;
+    *vars = nullptr;
+
+    return to_variable_list(static_cast<const flunder::client_t*>(flunder)->get(topic), vars, n);
+}
+
+FLECS_EXPORT int flunder_list_keys(
+    const void* flunder, const char* prefix, variable_t** vars, size_t* n)
+{
+    *n = 0;
+    *vars = nullptr;
+
+    const auto client = static_cast<const flunder::client_t*>(flunder);
+    return to_variable_list(client->list_keys(prefix), vars, n);
+}
+
 FLECS_EXPORT int flunder_publish_bool(const void* flunder, const char* topic, bool value)
 {
     return static_cast<const flunder::client_t*>(flunder)->publish(topic, value);
@@ -0,0 +1,325 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/column_set.h"
+
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+namespace flunder {
+
+namespace {
+
+/* 10^0 to 10^22 are exact doubles */
+constexpr double POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+constexpr std::uint64_t POW10_INT[] = {
+    1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000};
+
+/* largest mantissa that converts to double without rounding */
+constexpr auto MAX_EXACT_MANTISSA = std::uint64_t{1} << 53;
+
+auto load8(const char* p) noexcept //
+    -> std::uint64_t
+{
+    auto val = std::uint64_t{};
+    std::memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+auto is_eight_digits(std::uint64_t val) noexcept //
+    -> bool
+{
+    return ((val & 0xf0f0f0f0f0f0f0f0) |
+            (((val + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) == 0x3333333333333333;
+}
+
+/* converts eight ascii digits with three multiplications instead of eight */
+auto parse_eight_digits(std::uint64_t val) noexcept //
+    -> std::uint32_t
+{
+    constexpr auto mask = std::uint64_t{0x000000ff000000ff};
+    constexpr auto mul1 = std::uint64_t{0x000f424000000064}; /* 100 + (1000000 << 32) */
+    constexpr auto mul2 = std::uint64_t{0x0000271000000001}; /* 1 + (10000 << 32) */
+    val -= 0x3030303030303030;
+    val = (val * 10) + (val >> 8);
+    return static_cast<std::uint32_t>(
+        (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32);
+}
+
+/* accumulates the digits starting at p into mantissa and returns the first non-digit */
+auto parse_digits(const char* p, const char* end, std::uint64_t& mantissa, int& digits) noexcept //
+    -> const char*
+{
+    if constexpr (std::endian::native == std::endian::little) {
+        while (end - p >= 8 && digits <= 11) {
+            const auto val = load8(p);
+            if (!is_eight_digits(val)) {
+                break;
+            }
+            mantissa = mantissa * 100'000'000 + parse_eight_digits(val);
+            digits += 8;
+            p += 8;
+        }
+    }
+    while (p != end && static_cast<unsigned char>(*p - '0') < 10) {
+        mantissa = mantissa * 10 + static_cast<unsigned char>(*p - '0');
+        ++digits;
+        ++p;
+    }
+    return p;
+}
+
+/* the eight characters at p, padded with '\0' past end. Only reads within [begin, end) and never
+ * through memory just written, which would stall store forwarding */
+auto load_padded(const char* begin, const char* p, const char* end) noexcept //
+    -> std::uint64_t
+{
+    const auto left = end - p;
+    if (left >= 8) {
+        return load8(p);
+    }
+    if (left <= 0) {
+        return 0;
+    }
+    if (end - begin >= 8) {
+        return load8(end - 8) >> (8 * (8 - left));
+    }
+    if (left >= 4) {
+        auto lo = std::uint32_t{};
+        auto hi = std::uint32_t{};
+        std::memcpy(&lo, p, sizeof(lo));
+        std::memcpy(&hi, end - 4, sizeof(hi));
+        return lo | (std::uint64_t{hi} << (8 * (left - 4)));
+    }
+    const auto byte = [p](std::ptrdiff_t i) {
+        return std::uint64_t{static_cast<unsigned char>(p[i])} << (8 * i);
+    };
+    return byte(0) | byte(left / 2) | byte(left - 1);
+}
+
+/* counts the leading digits of eight characters and converts them, without branching on the
+ * number of digits */
+auto parse_up_to_eight_digits(std::uint64_t val) noexcept //
+    -> std::tuple<std::uint64_t, int>
+{
+    /* a byte is no digit if its high nibble differs from '0' or its low nibble exceeds 9 */
+    const auto x = val ^ 0x3030303030303030;
+    const auto high = (x | ((x & 0x0f0f0f0f0f0f0f0f) + 0x0606060606060606)) & 0xf0f0f0f0f0f0f0f0;
+    const auto non_digits = (high | (high << 1) | (high << 2) | (high << 3)) & 0x8080808080808080;
+    const auto count = std::countr_zero(non_digits) / 8;
+    if (count == 0) {
+        return {0, 0};
+    }
+    /* move the digits to the end and pad the front with '0' */
+    const auto shift = 8 * (8 - count);
+    const auto aligned = shift ? (val << shift) | (0x3030303030303030 >> (64 - shift)) : val;
+    return {parse_eight_digits(aligned), count};
+}
+
+/* parses plain decimals whose digits fit into 53 bits directly, eight digits at a time: dividing
+ * by an exact power of ten is a single correctly rounded operation, so this matches strtod.
+ * Exponents, longer mantissas, inf and nan are left to std::from_chars */
+auto parse_number(std::string_view str, double& value) noexcept //
+    -> bool
+{
+    if constexpr (std::endian::native == std::endian::little) {
+        const auto* begin = str.data();
+        const auto* end = begin + str.size();
+        const auto* p = begin;
+        const auto negative = (p != end && *p == '-');
+        p += negative;
+
+        auto mantissa = std::uint64_t{};
+        auto digits = 0;
+        auto parse_run = [begin, end, &p, &mantissa, &digits]() {
+            const auto [run, count] = parse_up_to_eight_digits(load_padded(begin, p, end));
+            mantissa = mantissa * POW10_INT[count] + run;
+            digits += count;
+            p += count;
+            return count;
+        };
+        if (parse_run() == 8) {
+            parse_run();
+        }
+        auto fraction = 0;
+        if (p != end && *p == '.') {
+            ++p;
+            const auto integer_digits = digits;
+            if (digits <= 11 && parse_run() == 8) {
+                parse_run();
+            }
+            fraction = digits - integer_digits;
+        }
+        if (p == end && digits > 0 && digits <= 19 && mantissa <= MAX_EXACT_MANTISSA) {
+            value = static_cast<double>(mantissa) / POW10[fraction];
+            value = negative ? -value : value;
+            return true;
+        }
+    }
+
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc{} && ptr == str.data() + str.size();
+}
+
+auto parse_timestamp(std::string_view str) noexcept //
+    -> std::uint64_t
+{
+    auto timestamp = std::uint64_t{};
+    auto digits = 0;
+    if (parse_digits(str.data(), str.data() + str.size(), timestamp, digits) !=
+            str.data() + str.size() ||
+        digits > 19) {
+        return 0;
+    }
+    return timestamp;
+}
+
+auto decode(const variable_t& var, double& value) noexcept //
+    -> bool
+{
+    const auto encoding = var.encoding();
+    if (encoding.empty() || encoding.starts_with("text/plain")) {
+        if (encoding == "text/plain;bool") {
+            const auto [res, b] = var.try_as<bool>();
+            value = b ? 1.0 : 0.0;
+            return res == 0;
+        }
+        /* 8-bit integers are a single raw byte rather than decimal text */
+        if (encoding == "text/plain;int8" || encoding == "text/plain;uint8") {
+            const auto [res, d] = var.try_as<double>();
+            value = d;
+            return res == 0;
+        }
+        return parse_number(var.value(), value);
+    }
+    if (encoding == "application/octet-stream" || encoding == "zenoh/bytes") {
+        if (var.len() != sizeof(double)) {
+            return false;
+        }
+        std::memcpy(&value, var.value().data(), sizeof(double));
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+FLECS_EXPORT column_set_t::column_set_t()
+    : _keys{}
+    , _key_offsets{0}
+    , _timestamps{}
+    , _values{}
+    , _validity{}
+{}
+
+FLECS_EXPORT column_set_t::column_set_t(column_set_t&& other) noexcept
+    : column_set_t{}
+{
+    swap(*this, other);
+}
+
+FLECS_EXPORT column_set_t& column_set_t::operator=(column_set_t&& other) noexcept
+{
+    swap(*this, other);
+    return *this;
+}
+
+FLECS_EXPORT column_set_t::~column_set_t()
+{}
+
+FLECS_EXPORT auto column_set_t::push_back(const variable_t& var) //
+    -> void
+{
+    const auto row = size();
+    if (row % 64 == 0) {
+        _validity.push_back(0);
+    }
+
+    _keys.append(var.topic());
+    _key_offsets.push_back(static_cast<std::uint32_t>(_keys.size()));
+    _timestamps.push_back(parse_timestamp(var.timestamp()));
+
+    auto value = 0.0;
+    if (decode(var, value)) {
+        _validity.back() |= std::uint64_t{1} << (row % 64);
+    } else {
+        value = 0.0;
+    }
+    _values.push_back(value);
+}
+
+FLECS_EXPORT auto column_set_t::append(std::span<const variable_t> vars) //
+    -> void
+{
+    const auto key_bytes = std::accumulate(
+        vars.begin(),
+        vars.end(),
+        std::size_t{},
+        [](std::size_t sum, const variable_t& var) { return sum + var.topic().size(); });
+    reserve(size() + vars.size(), _keys.size() + key_bytes);
+    for (const auto& var : vars) {
+        push_back(var);
+    }
+}
+
+FLECS_EXPORT auto column_set_t::reserve(std::size_t rows, std::size_t key_bytes) //
+    -> void
+{
+    _keys.reserve(key_bytes);
+    _key_offsets.reserve(rows + 1);
+    _timestamps.reserve(rows);
+    _values.reserve(rows);
+    _validity.reserve((rows + 63) / 64);
+}
+
+FLECS_EXPORT auto column_set_t::clear() noexcept //
+    -> void
+{
+    _keys.clear();
+    _key_offsets.assign(1, 0);
+    _timestamps.clear();
+    _values.clear();
+    _validity.clear();
+}
+
+FLECS_EXPORT auto column_set_t::valid_count() const noexcept //
+    -> std::size_t
+{
+    auto count = std::size_t{};
+    for (const auto word : _validity) {
+        count += static_cast<std::size_t>(std::popcount(word));
+    }
+    return count;
+}
+
+FLECS_EXPORT auto swap(column_set_t& lhs, column_set_t& rhs) noexcept //
+    -> void
+{
+    using std::swap;
+    swap(lhs._keys, rhs._keys);
+    swap(lhs._key_offsets, rhs._key_offsets);
+    swap(lhs._timestamps, rhs._timestamps);
+    swap(lhs._values, rhs._values);
+    swap(lhs._validity, rhs._validity);
+}
+
+} // namespace flunder
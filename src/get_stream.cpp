@@ -0,0 +1,95 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/get_stream.h"
+
+#include "flunder/client.h"
+#include "flunder/impl/get_stream.h"
+
+namespace flunder {
+
+get_stream_t::get_stream_t()
+    : _impl{new impl::get_stream_t{}}
+{}
+
+get_stream_t::get_stream_t(get_stream_t&& other) noexcept
+    : get_stream_t{}
+{
+    swap(*this, other);
+}
+
+get_stream_t& get_stream_t::operator=(get_stream_t&& other) noexcept
+{
+    swap(*this, other);
+    return *this;
+}
+
+get_stream_t::~get_stream_t()
+{}
+
+auto get_stream_t::is_open() const noexcept //
+    -> bool
+{
+    return _impl->is_open();
+}
+
+auto get_stream_t::next() //
+    -> const variable_t*
+{
+    return _impl->next();
+}
+
+auto get_stream_t::cancel() //
+    -> void
+{
+    _impl->cancel();
+}
+
+auto get_stream_t::timed_out() const noexcept //
+    -> bool
+{
+    return _impl->timed_out();
+}
+
+auto swap(get_stream_t& lhs, get_stream_t& rhs) noexcept //
+    -> void
+{
+    using std::swap;
+    swap(lhs._impl, rhs._impl);
+}
+
+} // namespace flunder
+
+extern "C" {
+
+FLECS_EXPORT void* flunder_get_stream_new(const void* flunder, const char* topic, size_t depth)
+{
+    auto [res, stream] = static_cast<const flunder::client_t*>(flunder)->get_stream(topic, depth);
+    if (res != 0) {
+        return nullptr;
+    }
+    return static_cast<void*>(new flunder::get_stream_t{std::move(stream)});
+}
+
+FLECS_EXPORT const variable_t* flunder_get_stream_next(void* stream)
+{
+    return static_cast<flunder::get_stream_t*>(stream)->next();
+}
+
+FLECS_EXPORT void flunder_get_stream_destroy(void* stream)
+{
+    delete static_cast<flunder::get_stream_t*>(stream);
+}
+
+} // extern "C"
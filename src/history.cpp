@@ -0,0 +1,141 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/history.h"
+
+#include <charconv>
+
+#include "flunder/aggregate.h"
+#include "flunder/client.h"
+#include "flunder/impl/series.h"
+
+namespace flunder {
+
+history_t::history_t(std::chrono::nanoseconds retention, std::size_t block_size)
+    : _retention{retention}
+    , _block_size{block_size}
+    , _series{}
+    , _mutex{}
+{}
+
+history_t::~history_t()
+{}
+
+auto history_t::append(std::string_view topic, sample_t sample) //
+    -> int
+{
+    auto lock = std::lock_guard{_mutex};
+
+    auto it = _series.find(topic);
+    if (it == _series.end()) {
+        it = _series.emplace(std::string{topic}, std::make_unique<impl::series_t>(_block_size))
+                 .first;
+    }
+
+    auto& series = *it->second;
+    if (series.append(sample) != 0) {
+        return -1;
+    }
+    series.expire(sample.timestamp - _retention.count());
+
+    return 0;
+}
+
+auto history_t::append(const variable_t& var) //
+    -> int
+{
+    const auto value = var.value();
+    auto sample = sample_t{};
+    const auto [value_end, value_ec] =
+        std::from_chars(value.data(), value.data() + value.size(), sample.value);
+    if (value_ec != std::errc{}) {
+        return -1;
+    }
+    const auto timestamp = var.timestamp();
+    const auto [timestamp_end, timestamp_ec] =
+        std::from_chars(timestamp.data(), timestamp.data() + timestamp.size(), sample.timestamp);
+    if (timestamp_ec != std::errc{}) {
+        return -1;
+    }
+    return append(var.topic(), sample);
+}
+
+auto history_t::record(client_t& client, std::string_view topic) //
+    -> int
+{
+    return client.subscribe(topic, [this](client_t*, const variable_t* var) { append(*var); });
+}
+
+auto history_t::range(std::string_view topic, std::int64_t start, std::int64_t end) const //
+    -> std::vector<sample_t>
+{
+    auto samples = std::vector<sample_t>{};
+    scan(topic, start, end, [&samples](std::span<const sample_t> block) {
+        samples.insert(samples.end(), block.begin(), block.end());
+    });
+    return samples;
+}
+
+auto history_t::scan(
+    std::string_view topic,
+    std::int64_t start,
+    std::int64_t end,
+    const scan_cbk_t& cbk) const //
+    -> void
+{
+    auto lock = std::lock_guard{_mutex};
+
+    const auto it = _series.find(topic);
+    if (it != _series.cend()) {
+        it->second->scan(start, end, cbk);
+    }
+}
+
+auto history_t::aggregate(
+    std::string_view topic,
+    std::int64_t start,
+    std::int64_t end,
+    aggregator_t& aggregator) const //
+    -> void
+{
+    auto lock = std::lock_guard{_mutex};
+
+    const auto it = _series.find(topic);
+    if (it != _series.cend()) {
+        it->second->aggregate(start, end, aggregator);
+    }
+}
+
+auto history_t::size(std::string_view topic) const //
+    -> std::size_t
+{
+    auto lock = std::lock_guard{_mutex};
+
+    const auto it = _series.find(topic);
+    return (it == _series.cend()) ? 0 : it->second->size();
+}
+
+auto history_t::memory_usage() const //
+    -> std::size_t
+{
+    auto lock = std::lock_guard{_mutex};
+
+    auto bytes = std::size_t{};
+    for (const auto& [topic, series] : _series) {
+        bytes += topic.capacity() + series->memory_usage();
+    }
+    return bytes;
+}
+
+} // namespace flunder
@@ -0,0 +1,175 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/batch.h"
+
+#include <algorithm>
+
+namespace flunder {
+namespace impl {
+
+batch_flusher_t::batch_flusher_t()
+    : _mutex{}
+    , _cv{}
+    , _scheduled{}
+    , _current{}
+    , _stop{}
+    , _thread{}
+{}
+
+batch_flusher_t::~batch_flusher_t()
+{
+    {
+        auto lock = std::lock_guard{_mutex};
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+auto batch_flusher_t::schedule(batch_t* batch, std::chrono::steady_clock::time_point deadline) //
+    -> void
+{
+    auto lock = std::lock_guard{_mutex};
+    const auto [it, inserted] = _scheduled.emplace(batch, deadline);
+    if (!inserted) {
+        it->second = std::min(it->second, deadline);
+    }
+    if (!_thread.joinable()) {
+        _thread = std::thread{&batch_flusher_t::run, this};
+    }
+    _cv.notify_all();
+}
+
+auto batch_flusher_t::cancel(batch_t* batch) //
+    -> void
+{
+    auto lock = std::unique_lock{_mutex};
+    _scheduled.erase(batch);
+    /* a callback unsubscribing its own subscription must not wait for itself */
+    if (std::this_thread::get_id() != _thread.get_id()) {
+        _cv.wait(lock, [this, batch] { return _current != batch; });
+    }
+}
+
+auto batch_flusher_t::run() //
+    -> void
+{
+    auto lock = std::unique_lock{_mutex};
+    while (!_stop) {
+        if (_scheduled.empty()) {
+            _cv.wait(lock);
+            continue;
+        }
+        const auto due = std::min_element(
+            _scheduled.cbegin(),
+            _scheduled.cend(),
+            [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+        if (due->second > std::chrono::steady_clock::now()) {
+            _cv.wait_until(lock, due->second);
+            continue;
+        }
+
+        _current = due->first;
+        _scheduled.erase(due);
+        lock.unlock();
+        _current->flush();
+        lock.lock();
+        _current = nullptr;
+        _cv.notify_all();
+    }
+}
+
+batch_t::batch_t(
+    flunder::client_t* client, cbk_t cbk, batch_options_t options, batch_flusher_t* flusher)
+    : _client{client}
+    , _cbk{std::move(cbk)}
+    , _options{options}
+    , _flusher{flusher}
+    , _mutex{}
+    , _pending{}
+    , _spare{}
+{
+    _options.max_items = std::max<std::size_t>(_options.max_items, 1);
+    if (_options.max_delay.count() > 0) {
+        _pending.reserve(_options.max_items);
+        _spare.reserve(_options.max_items);
+    } else {
+        _flusher = nullptr;
+    }
+}
+
+batch_t::~batch_t()
+{
+    if (_flusher) {
+        _flusher->cancel(this);
+    }
+    flush();
+}
+
+auto batch_t::push(variable_t var) //
+    -> void
+{
+    if (!_flusher) {
+        return _cbk(_client, std::span<const variable_t>{&var, 1});
+    }
+
+    auto lock = std::unique_lock{_mutex};
+    const auto now = std::chrono::steady_clock::now();
+    _pending.emplace_back(std::move(var));
+    /* arm the deadline with the first sample, deliver full batches right away */
+    if (_pending.size() >= _options.max_items) {
+        _flusher->schedule(this, now);
+    } else if (_pending.size() == 1) {
+        _flusher->schedule(this, now + _options.max_delay);
+    }
+}
+
+auto batch_t::deliver(std::span<const variable_t> vars) //
+    -> void
+{
+    while (!vars.empty()) {
+        const auto n = std::min(vars.size(), _options.max_items);
+        _cbk(_client, vars.first(n));
+        vars = vars.subspan(n);
+    }
+}
+
+auto batch_t::flush() //
+    -> void
+{
+    auto lock = std::unique_lock{_mutex};
+    if (!_pending.empty()) {
+        flush(lock);
+    }
+}
+
+auto batch_t::flush(std::unique_lock<std::mutex>& lock) //
+    -> void
+{
+    auto batch = std::move(_pending);
+    _pending = std::move(_spare);
+    lock.unlock();
+
+    deliver(batch);
+    batch.clear();
+
+    lock.lock();
+    _spare = std::move(batch);
+}
+
+} // namespace impl
+} // namespace flunder
@@ -16,11 +16,24 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
 #include <cstdio>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
 #include <nlohmann/json.hpp>
+#include <span>
 #include <thread>
 #include <tuple>
+#include <utility>
 
+#include "flunder/impl/get_stream.h"
+#include "flunder/impl/local_storage.h"
+#include "flunder/impl/outbox.h"
+#include "flunder/impl/session_registry.h"
 #include "flunder/to_string.h"
 
 namespace flunder {
@@ -33,6 +46,27 @@ struct overload : Ts...
     using Ts::operator()...;
 };
 
+static auto invoke(
+    const client_t::subscribe_cbk_var_t& cbk,
+    flunder::client_t* client,
+    const variable_t* var,
+    const void* userp) //
+    -> void
+{
+    if (const auto* bound = std::get_if<client_t::bound_cbk_t>(&cbk)) {
+        return bound->_invoke(bound->_obj.get(), client, var);
+    }
+    std::visit(
+        overload{
+            // call callback without userdata
+            [&](const client_t::subscribe_cbk_t& cbk) { cbk(client, var); },
+            // call callback with userdata
+            [&](const client_t::subscribe_cbk_userp_t& cbk) { cbk(client, var, userp); },
+            // handled above
+            [](const client_t::bound_cbk_t&) {}},
+        cbk);
+}
+
 static auto lib_subscribe_callback(z_loaned_sample_t* sample, void* arg) //
     -> void
 {
@@ -41,119 +75,629 @@ static auto lib_subscribe_callback(z_loaned_sample_t* sample, void* arg) //
         return;
     }
 
+    if (ctx->_batch) {
+        return ctx->_batch->push(to_variable(sample));
+    }
+
+    auto& dispatch = *ctx->_dispatch;
+    if (dispatch.busy.exchange(true, std::memory_order_acquire)) {
+        /* nested or concurrent dispatch; the buffers still back the variable of the outer one */
+        const auto var = to_variable(sample);
+        return invoke(ctx->_cbk, ctx->_client, &var, ctx->_userp);
+    }
+    const auto var = to_variable(sample, dispatch.buffers);
+    invoke(ctx->_cbk, ctx->_client, &var, ctx->_userp);
+    dispatch.busy.store(false, std::memory_order_release);
+}
+
+/*! State of an asynchronous get, shared between the reply closure and the issuing call. The
+ * result is delivered once both the closure has been dropped and z_get has returned, so that
+ * errors from z_get can be reported without racing the drop of the closure. */
+struct get_async_ctx_t
+{
+    client_t::get_cbk_t _cbk;
+    std::vector<variable_t> _vars;
+    std::atomic<int> _pending;
+    int _res;
+
+    auto release() //
+        -> void
+    {
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            auto self = std::unique_ptr<get_async_ctx_t>{this};
+            _cbk(_res, std::move(_vars));
+        }
+    }
+};
+
+static auto lib_get_reply_callback(z_loaned_reply_t* reply, void* arg) //
+    -> void
+{
+    auto* ctx = static_cast<get_async_ctx_t*>(arg);
+    if (!z_reply_is_ok(reply)) {
+        return;
+    }
+    const auto sample = z_reply_ok(reply);
+
     auto keyexpr = z_view_string_t{};
     z_keyexpr_as_view_string(z_sample_keyexpr(sample), &keyexpr);
+    if (z_string_len(z_loan(keyexpr)) > 0 && *z_string_data(z_loan(keyexpr)) == '@') {
+        return;
+    }
 
-    auto payload_reader = z_bytes_get_reader(z_sample_payload(sample));
-    const auto payload_len = z_bytes_reader_remaining(&payload_reader);
-    auto payload = std::string(payload_len, '\0');
-    z_bytes_reader_read(&payload_reader, reinterpret_cast<uint8_t*>(payload.data()), payload_len);
+    ctx->_vars.emplace_back(to_variable(sample));
+}
 
-    auto encoding = z_owned_string_t{};
-    z_encoding_to_string(z_sample_encoding(sample), &encoding);
-    auto timestamp = z_sample_timestamp(sample);
+static auto lib_get_drop_callback(void* arg) //
+    -> void
+{
+    static_cast<get_async_ctx_t*>(arg)->release();
+}
 
-    const auto var = variable_t{
-        std::string{z_string_data(z_loan(keyexpr)), z_string_len(z_loan(keyexpr))},
-        std::move(payload),
-        std::string{z_string_data(z_loan(encoding)), z_string_len(z_loan(encoding))},
-        flunder::to_string(ntp64_to_unix_time(z_timestamp_ntp64_time(timestamp)))};
+/*! Results of a get_many, shared by the closures of all issued queries. Once the caller stops
+ * waiting, the results are handed out and late replies are discarded. */
+struct get_many_ctx_t
+{
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::vector<std::vector<variable_t>> _results;
+    std::size_t _pending;
+    bool _abandoned;
+};
 
-    z_drop(z_move(encoding));
+struct get_many_query_t
+{
+    std::shared_ptr<get_many_ctx_t> _ctx;
+    std::size_t _index;
+};
 
-    std::visit(
-        overload{
-            // call callback without userdata
-            [&](client_t::subscribe_cbk_t cbk) { cbk(ctx->_client, &var); },
-            // call callback with userdata
-            [&](client_t::subscribe_cbk_userp_t cbk) { cbk(ctx->_client, &var, ctx->_userp); }},
-        ctx->_cbk);
+static auto lib_get_many_reply_callback(z_loaned_reply_t* reply, void* arg) //
+    -> void
+{
+    const auto* query = static_cast<const get_many_query_t*>(arg);
+    if (!z_reply_is_ok(reply)) {
+        return;
+    }
+    const auto sample = z_reply_ok(reply);
+
+    auto keyexpr = z_view_string_t{};
+    z_keyexpr_as_view_string(z_sample_keyexpr(sample), &keyexpr);
+    if (z_string_len(z_loan(keyexpr)) > 0 && *z_string_data(z_loan(keyexpr)) == '@') {
+        return;
+    }
+
+    auto var = to_variable(sample);
+    auto lock = std::lock_guard{query->_ctx->_mutex};
+    if (!query->_ctx->_abandoned) {
+        query->_ctx->_results[query->_index].emplace_back(std::move(var));
+    }
+}
+
+static auto lib_get_many_drop_callback(void* arg) //
+    -> void
+{
+    const auto query = std::unique_ptr<get_many_query_t>{static_cast<get_many_query_t*>(arg)};
+    auto lock = std::lock_guard{query->_ctx->_mutex};
+    --query->_ctx->_pending;
+    query->_ctx->_cv.notify_all();
 }
 
 client_t::client_t()
     : _mem_storages{}
-    , _host{}
-    , _port{}
+    , _mem_storages_mutex{}
+    , _local_storages{}
+    , _connect_options{}
     , _z_session{}
+    , _shards{}
+    , _session_mutex{}
+    , _batch_flusher{}
     , _subscriptions{}
+    , _queryables{}
+    , _outbox{}
+    , _monitor{}
+    , _executor{}
+    , _resume_thread{}
+    , _state{connection_state_t::disconnected}
+    , _state_cbk{}
+    , _connector{}
+    , _connect_stop{}
+    , _queued_publishes{}
+    , _connect_cv{}
+    , _connect_mutex{}
 {}
 
 client_t::~client_t()
 {}
 
+static auto is_valid(const connect_options_t& options) //
+    -> bool
+{
+    /* peers may form a network without any router */
+    return !options.endpoints.empty() ||
+           (options.mode == session_mode_t::peer && (!options.listen.empty() || options.scouting));
+}
+
+/*! zenoh configuration applied for profile, as keys and JSON5 values */
+static auto profile_config(transport_profile_t profile) //
+    -> std::span<const std::pair<const char*, const char*>>
+{
+    static constexpr auto low_latency = std::to_array<std::pair<const char*, const char*>>({
+        {"transport/link/tx/queue/batching/enabled", "false"},
+        {"transport/link/tx/queue/size/real_time", "1"},
+        {"transport/link/tx/queue/size/interactive_high", "1"},
+        {"transport/link/tx/queue/size/interactive_low", "1"},
+        {"transport/link/tx/queue/size/data_high", "1"},
+        {"transport/link/tx/queue/size/data", "1"},
+        {"transport/link/tx/queue/size/data_low", "1"},
+        {"transport/link/tx/lease", "1000"},
+        {"transport/link/tx/keep_alive", "4"},
+    });
+    static constexpr auto high_throughput = std::to_array<std::pair<const char*, const char*>>({
+        {"transport/link/tx/batch_size", "65535"},
+        {"transport/link/tx/queue/batching/enabled", "true"},
+        {"transport/link/tx/queue/size/data_high", "16"},
+        {"transport/link/tx/queue/size/data", "16"},
+        {"transport/link/tx/queue/size/data_low", "16"},
+        {"transport/link/tx/queue/size/background", "16"},
+        {"transport/link/rx/buffer_size", "1048576"},
+    });
+    static constexpr auto constrained_memory = std::to_array<std::pair<const char*, const char*>>({
+        {"transport/link/tx/batch_size", "8192"},
+        {"transport/link/tx/queue/size/data_high", "1"},
+        {"transport/link/tx/queue/size/data", "1"},
+        {"transport/link/tx/queue/size/data_low", "1"},
+        {"transport/link/tx/queue/size/background", "1"},
+        {"transport/link/tx/threads", "1"},
+        {"transport/link/rx/buffer_size", "8192"},
+        {"transport/link/rx/max_message_size", "16777216"},
+    });
+
+    switch (profile) {
+        case transport_profile_t::low_latency:
+            return low_latency;
+        case transport_profile_t::high_throughput:
+            return high_throughput;
+        case transport_profile_t::constrained_memory:
+            return constrained_memory;
+        case transport_profile_t::balanced:
+        default:
+            return {};
+    }
+}
+
 auto client_t::connect(std::string_view host, int port) //
     -> int
+{
+    auto options = connect_options_t{};
+    options.endpoints.push_back("tcp/" + std::string{host} + ":" + std::to_string(port));
+    return connect(std::move(options));
+}
+
+auto client_t::connect(connect_options_t options) //
+    -> int
 {
     disconnect();
 
-    _host = host;
-    _port = port;
+    if (!is_valid(options)) {
+        return -1;
+    }
+    auto session = acquire_session(options);
+    auto shards = std::vector<session_ptr_t>{};
+    if (!session || open_shards(options, shards) != 0) {
+        return -1;
+    }
+    install_session(std::move(session), std::move(shards));
+    _connect_options = std::move(options);
+    set_state(connection_state_t::connected);
+    start_outbox();
+    start_monitor();
 
-    const auto len = std::snprintf(nullptr, 0, "[\"tcp/%s:%d\"]", host.data(), port);
-    auto remote = std::string(len, '\0');
-    std::snprintf(remote.data(), remote.length() + 1, "[\"tcp/%s:%d\"]", host.data(), port);
+    return 0;
+}
+
+auto client_t::connect_async(connect_options_t options, connect_cbk_t cbk) //
+    -> std::future<int>
+{
+    disconnect();
 
+    auto promise = std::promise<int>{};
+    auto future = promise.get_future();
+    if (!is_valid(options)) {
+        promise.set_value(-1);
+        if (cbk) {
+            cbk(-1);
+        }
+        return future;
+    }
+    /* a config rejected by zenoh is rejected on every attempt, so only z_open is retried */
     auto config = z_owned_config_t{};
+    if (make_config(options, config) != 0) {
+        promise.set_value(-EINVAL);
+        if (cbk) {
+            cbk(-EINVAL);
+        }
+        return future;
+    }
+    z_drop(z_move(config));
+
+    _connect_options = std::move(options);
+    _connect_stop = false;
+    set_state(connection_state_t::connecting);
+    _connector = std::thread{[this, promise = std::move(promise), cbk = std::move(cbk)]() mutable {
+        const auto res = connector();
+        promise.set_value(res);
+        if (cbk) {
+            cbk(res);
+        }
+    }};
+
+    return future;
+}
+
+auto client_t::connector() //
+    -> int
+{
+    auto delay = _connect_options.reconnect_delay_min;
+    auto session = session_ptr_t{};
+    auto shards = std::vector<session_ptr_t>{};
+    while (!(session = acquire_session(_connect_options)) ||
+           open_shards(_connect_options, shards) != 0) {
+        session.reset();
+        auto lock = std::unique_lock{_connect_mutex};
+        if (_connect_cv.wait_for(lock, delay, [this] { return _connect_stop; })) {
+            return -ECANCELED;
+        }
+        delay = std::min(delay * 2, _connect_options.reconnect_delay_max);
+    }
+
+    auto pending = std::vector<std::pair<const std::string*, subscribe_ctx_t*>>{};
     {
-        auto res = z_config_default(&config);
-        res |= zc_config_insert_json5(z_loan_mut(config), Z_CONFIG_CONNECT_KEY, remote.c_str());
-        res |= zc_config_insert_json5(z_loan_mut(config), Z_CONFIG_MODE_KEY, R"#("client")#");
-        res |= zc_config_insert_json5(z_loan_mut(config), Z_CONFIG_MULTICAST_SCOUTING_KEY, "false");
-        res |= zc_config_insert_json5(z_loan_mut(config), "timestamping/enabled", "true");
-        if (res) {
-            return -1;
+        auto lock = std::lock_guard{_connect_mutex};
+        if (_connect_stop) {
+            return -ECANCELED;
+        }
+        install_session(std::move(session), std::move(shards));
+
+        /* publishes issued from now on block on _connect_mutex until the queue is flushed, so
+         * their order is kept */
+        while (!_queued_publishes.empty()) {
+            auto& queued = _queued_publishes.front();
+            auto timestamp = z_timestamp_t{};
+            z_timestamp_new(&timestamp, z_loan(*_z_session));
+            timestamp.time = unix_time_to_ntp64(queued.timestamp);
+            do_put(queued.topic, queued.encoding, queued.value, &timestamp);
+            _queued_publishes.pop_front();
+        }
+        for (auto& [topic, ctx] : _subscriptions) {
+            if (declare_subscriber(topic, ctx) == 0) {
+                pending.emplace_back(&topic, &ctx);
+            }
+        }
+        _state = connection_state_t::connected;
+        start_outbox();
+        start_monitor();
+
+        /* initial values can only be queried once the state is connected */
+        for (const auto& [topic, ctx] : pending) {
+            initial_get(*topic, *ctx);
+        }
+    }
+    if (_state_cbk) {
+        _state_cbk(connection_state_t::connected);
+    }
+
+    return 0;
+}
+
+auto client_t::stop_connector() //
+    -> void
+{
+    {
+        auto lock = std::lock_guard{_connect_mutex};
+        _connect_stop = true;
+    }
+    _connect_cv.notify_all();
+    if (_connector.joinable()) {
+        _connector.join();
+    }
+}
+
+auto client_t::set_state(connection_state_t state) //
+    -> void
+{
+    if (_state.exchange(state) != state && _state_cbk) {
+        _state_cbk(state);
+    }
+}
+
+auto client_t::on_state_change(state_cbk_t cbk) //
+    -> void
+{
+    _state_cbk = std::move(cbk);
+}
+
+auto client_t::state() const noexcept //
+    -> connection_state_t
+{
+    return _state;
+}
+
+auto client_t::make_config(const connect_options_t& options, z_owned_config_t& config) //
+    -> int
+{
+    const auto endpoints = nlohmann::json(options.endpoints).dump();
+    const auto listen = nlohmann::json(options.listen).dump();
+    const auto mode = (options.mode == session_mode_t::peer) ? R"#("peer")#" : R"#("client")#";
+    auto retry = nlohmann::json{};
+    retry["period_init_ms"] = options.reconnect_delay_min.count();
+    retry["period_max_ms"] = options.reconnect_delay_max.count();
+    retry["period_increase_factor"] = 2;
+
+    auto res = z_config_default(&config);
+    res |= zc_config_insert_json5(z_loan_mut(config), Z_CONFIG_CONNECT_KEY, endpoints.c_str());
+    res |= zc_config_insert_json5(z_loan_mut(config), "connect/retry", retry.dump().c_str());
+    res |= zc_config_insert_json5(z_loan_mut(config), Z_CONFIG_LISTEN_KEY, listen.c_str());
+    res |= zc_config_insert_json5(z_loan_mut(config), Z_CONFIG_MODE_KEY, mode);
+    res |= zc_config_insert_json5(
+        z_loan_mut(config),
+        Z_CONFIG_MULTICAST_SCOUTING_KEY,
+        options.scouting ? "true" : "false");
+    res |= zc_config_insert_json5(z_loan_mut(config), "timestamping/enabled", "true");
+    for (const auto& [key, value] : profile_config(options.profile)) {
+        res |= zc_config_insert_json5(z_loan_mut(config), key, value);
+    }
+    for (const auto& [key, value] : options.config) {
+        if (zc_config_insert_json5(z_loan_mut(config), key.c_str(), value.c_str()) != 0) {
+            std::fprintf(
+                stderr,
+                "[flunder] Invalid config %s: %s\n",
+                key.c_str(),
+                value.c_str());
+            res = -1;
         }
     }
+    if (res) {
+        z_drop(z_move(config));
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+auto client_t::open_session(const connect_options_t& options, z_owned_session_t& session) //
+    -> int
+{
+    auto config = z_owned_config_t{};
+    if (make_config(options, config) != 0) {
+        return -1;
+    }
 
-    const auto res = z_open(&_z_session, z_move(config), nullptr);
+    const auto endpoints = nlohmann::json(options.endpoints).dump();
+    const auto res = z_open(&session, z_move(config), nullptr);
     if (res < 0) {
-        std::fprintf(stderr, "[flunder] Could not connect to %s:%d: %d\n", host.data(), port, res);
-        z_drop(z_move(_z_session));
-        _z_session = z_owned_session_t{};
+        std::fprintf(stderr, "[flunder] Could not connect to %s: %d\n", endpoints.c_str(), res);
+        z_drop(z_move(session));
+        session = z_owned_session_t{};
         return -1;
     }
 
     return 0;
 }
 
+auto client_t::acquire_session(const connect_options_t& options) //
+    -> session_ptr_t
+{
+    const auto open = [this, &options]() -> session_ptr_t {
+        auto session = z_owned_session_t{};
+        if (open_session(options, session) != 0) {
+            return nullptr;
+        }
+        /* a routerless peer has nothing to lose */
+        if (options.endpoints.empty()) {
+            return make_session(session);
+        }
+        return make_session(
+            session,
+            options.mode == session_mode_t::peer,
+            options.health_interval);
+    };
+    if (!options.shared_session) {
+        return open();
+    }
+
+    /* clients connecting with equal options share a session */
+    auto key = nlohmann::json{};
+    key["endpoints"] = options.endpoints;
+    key["mode"] = static_cast<int>(options.mode);
+    key["listen"] = options.listen;
+    key["scouting"] = options.scouting;
+    key["profile"] = static_cast<int>(options.profile);
+    key["config"] = options.config;
+    return session_registry_t::instance().acquire(key.dump(), open);
+}
+
+auto client_t::open_shards(const connect_options_t& options, std::vector<session_ptr_t>& shards) //
+    -> int
+{
+    /* shards are never shared, as they exist to spread the load of this client */
+    shards.clear();
+    for (auto i = std::size_t{1}; i < options.shards; ++i) {
+        auto session = z_owned_session_t{};
+        if (open_session(options, session) != 0) {
+            shards.clear();
+            return -1;
+        }
+        shards.push_back(make_session(session));
+    }
+    return 0;
+}
+
+auto client_t::publish_session(std::string_view topic) const //
+    -> const z_owned_session_t&
+{
+    if (_shards.empty()) {
+        return *_z_session;
+    }
+    /* all samples of a topic go through the same session, which keeps them in order */
+    const auto shard = std::hash<std::string_view>{}(topic) % (_shards.size() + 1);
+    return (shard == 0) ? *_z_session : *_shards[shard - 1];
+}
+
+auto client_t::install_session(session_ptr_t session, std::vector<session_ptr_t> shards) //
+    -> void
+{
+    auto lock = std::unique_lock{_session_mutex};
+    _z_session = std::move(session);
+    _shards = std::move(shards);
+}
+
+auto client_t::close_session() //
+    -> void
+{
+    auto session = session_ptr_t{};
+    auto shards = std::vector<session_ptr_t>{};
+    {
+        /* closing waits for running callbacks, which may publish, so only the swap is guarded */
+        auto lock = std::unique_lock{_session_mutex};
+        session = std::exchange(_z_session, {});
+        shards = std::exchange(_shards, {});
+    }
+    shards.clear();
+    session.reset();
+}
+
 auto client_t::is_connected() const noexcept //
     -> bool
 {
-    return z_internal_check(_z_session);
+    const auto state = _state.load();
+    return state == connection_state_t::connected || state == connection_state_t::reconnecting;
 }
 
 auto client_t::reconnect() //
     -> int
 {
-    const auto host = _host;
-    const auto port = _port;
+    if (!is_valid(_connect_options)) {
+        return -1;
+    }
 
-    disconnect();
-    return connect(host, port);
+    stop_monitor();
+    if (_outbox) {
+        _outbox->stop();
+    }
+    set_state(connection_state_t::reconnecting);
+
+    /* keep all contexts, so everything can be declared again on the new session */
+    for (auto& [topic, ctx] : _subscriptions) {
+        z_undeclare_subscriber(z_move(ctx._sub));
+    }
+    for (auto& [key_expr, ctx] : _queryables) {
+        z_undeclare_queryable(z_move(ctx._queryable));
+    }
+    for (auto& [name, storage] : _local_storages) {
+        storage->undeclare();
+    }
+    /* publishes and gets issued until the new session is installed fail instead of using the
+     * closed one */
+    close_session();
+
+    auto session = acquire_session(_connect_options);
+    auto shards = std::vector<session_ptr_t>{};
+    if (!session || open_shards(_connect_options, shards) != 0) {
+        set_state(connection_state_t::disconnected);
+        return -1;
+    }
+    install_session(std::move(session), std::move(shards));
+
+    auto res = 0;
+    for (auto& [topic, ctx] : _subscriptions) {
+        res |= declare_subscriber(topic, ctx);
+    }
+    for (auto& [key_expr, ctx] : _queryables) {
+        res |= declare_queryable(key_expr, ctx);
+    }
+    for (auto& [name, storage] : _local_storages) {
+        res |= storage->declare(_z_session.get());
+    }
+    set_state(connection_state_t::connected);
+    restore_mem_storages();
+    start_outbox();
+    start_monitor();
+
+    return (res == 0) ? 0 : -1;
 }
 
 auto client_t::disconnect() //
     -> int
 {
+    stop_connector();
+    stop_monitor();
     while (!_subscriptions.empty()) {
         unsubscribe(_subscriptions.rbegin()->first);
     }
-    while (!_mem_storages.empty()) {
-        remove_mem_storage(_mem_storages.rbegin()->name);
+    while (!_queryables.empty()) {
+        unserve(_queryables.rbegin()->first);
     }
-    if (is_connected()) {
-        auto opt = z_close_options_t{};
-        z_close_options_default(&opt);
-        z_close(z_loan_mut(_z_session), &opt);
-        z_drop(z_move(_z_session));
-        _z_session = z_owned_session_t{};
+    auto names = std::vector<std::string>{};
+    {
+        auto lock = std::lock_guard{_mem_storages_mutex};
+        for (const auto& storage : _mem_storages) {
+            names.push_back(storage.name);
+        }
+    }
+    for (const auto& name : names) {
+        remove_mem_storage(name);
+    }
+    {
+        /* without a session, storages cannot be removed from the router and are only forgotten */
+        auto lock = std::lock_guard{_mem_storages_mutex};
+        _mem_storages.clear();
+    }
+    _local_storages.clear();
+    if (_outbox) {
+        _outbox->stop();
     }
-    _host.clear();
-    _port = 0;
+    for (auto& queued : _queued_publishes) {
+        z_drop(z_move(queued.encoding));
+        z_drop(z_move(queued.value));
+    }
+    _queued_publishes.clear();
+    close_session();
+    _connect_options = connect_options_t{};
+    set_state(connection_state_t::disconnected);
 
     return 0;
 }
 
+auto client_t::start_monitor() //
+    -> void
+{
+    _monitor = _z_session ? session_monitor(_z_session) : nullptr;
+    if (_monitor) {
+        _monitor->watch(this, [this](bool online) { on_health_change(online); });
+    }
+}
+
+auto client_t::stop_monitor() //
+    -> void
+{
+    if (_monitor) {
+        _monitor->unwatch(this);
+        _monitor = nullptr;
+    }
+}
+
+auto client_t::on_health_change(bool online) //
+    -> void
+{
+    /* state held by the router has to be restored once a router is back */
+    if (online) {
+        restore_mem_storages();
+        set_state(connection_state_t::connected);
+    } else {
+        set_state(connection_state_t::reconnecting);
+    }
+}
+
 auto client_t::publish(
     std::string_view topic,
     z_owned_bytes_t value,
@@ -300,7 +844,41 @@ auto client_t::do_publish(
     z_owned_bytes_t value) const //
     -> int
 {
+    if (_outbox && (!is_connected() || _outbox->is_buffering())) {
+        return do_buffer(topic, encoding, value);
+    }
     if (!is_connected()) {
+        return do_queue(topic, encoding, value);
+    }
+    if (!_outbox) {
+        return do_put(topic, encoding, value, nullptr);
+    }
+
+    /* keep a reference to the payload to buffer it if publishing fails */
+    auto retained_encoding = z_owned_encoding_t{};
+    z_encoding_clone(&retained_encoding, z_loan(encoding));
+    auto retained_value = z_owned_bytes_t{};
+    z_bytes_clone(&retained_value, z_loan(value));
+    if (do_put(topic, encoding, value, nullptr) != 0) {
+        return do_buffer(topic, retained_encoding, retained_value);
+    }
+    z_drop(z_move(retained_encoding));
+    z_drop(z_move(retained_value));
+
+    return 0;
+}
+
+auto client_t::do_put(
+    std::string_view topic,
+    z_owned_encoding_t encoding,
+    z_owned_bytes_t value,
+    z_timestamp_t* timestamp) const //
+    -> int
+{
+    auto lock = std::shared_lock{_session_mutex};
+    if (!_z_session) {
+        z_drop(z_move(encoding));
+        z_drop(z_move(value));
         return -1;
     }
 
@@ -309,110 +887,295 @@ auto client_t::do_publish(
     options.encoding = z_move(encoding);
     options.congestion_control = z_congestion_control_t::Z_CONGESTION_CONTROL_BLOCK;
     options.reliability = z_reliability_t::Z_RELIABILITY_RELIABLE;
+    options.timestamp = timestamp;
 
+    const auto key = topic.starts_with('/') ? topic.substr(1) : topic;
     auto keyexpr = z_view_keyexpr_t{};
-    z_view_keyexpr_from_str(&keyexpr, topic.starts_with('/') ? topic.data() + 1 : topic.data());
+    z_view_keyexpr_from_str(&keyexpr, key.data());
 
-    const auto res = z_put(z_loan(_z_session), z_loan(keyexpr), z_move(value), &options);
+    const auto& session = publish_session(key);
+    const auto res = z_put(z_loan(session), z_loan(keyexpr), z_move(value), &options);
 
     return (res == 0) ? 0 : -1;
 }
 
-auto client_t::subscribe(
-    flunder::client_t* client,
+auto client_t::do_queue(
     std::string_view topic,
-    client_t::subscribe_cbk_t cbk) //
+    z_owned_encoding_t encoding,
+    z_owned_bytes_t value) const //
     -> int
 {
-    return do_subscribe(client, topic, subscribe_cbk_var_t{cbk}, nullptr);
+    {
+        auto lock = std::lock_guard{_connect_mutex};
+        if (_state.load() == connection_state_t::connecting &&
+            _queued_publishes.size() < _connect_options.max_queued_publishes) {
+            const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch());
+            _queued_publishes.push_back(queued_publish_t{
+                std::string{topic.starts_with('/') ? topic.substr(1) : topic},
+                encoding,
+                value,
+                static_cast<std::uint64_t>(now.count())});
+            return 0;
+        }
+    }
+    /* the session may have been established in the meantime */
+    if (!is_connected()) {
+        z_drop(z_move(encoding));
+        z_drop(z_move(value));
+        return -1;
+    }
+    return do_put(topic, encoding, value, nullptr);
 }
 
-auto client_t::subscribe(
-    flunder::client_t* client,
+auto client_t::do_buffer(
     std::string_view topic,
-    client_t::subscribe_cbk_userp_t cbk,
-    const void* userp) //
+    z_owned_encoding_t encoding,
+    z_owned_bytes_t value) const //
     -> int
 {
-    return do_subscribe(client, topic, subscribe_cbk_var_t{cbk}, userp);
+    auto enc = z_owned_string_t{};
+    z_encoding_to_string(z_loan(encoding), &enc);
+    z_drop(z_move(encoding));
+
+    auto reader = z_bytes_get_reader(z_loan(value));
+    auto payload = std::string(z_bytes_reader_remaining(&reader), '\0');
+    z_bytes_reader_read(&reader, reinterpret_cast<uint8_t*>(payload.data()), payload.size());
+    z_drop(z_move(value));
+
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    const auto res = _outbox->append(
+        topic.starts_with('/') ? topic.substr(1) : topic,
+        payload,
+        std::string_view{z_string_data(z_loan(enc)), z_string_len(z_loan(enc))},
+        static_cast<std::uint64_t>(now.count()));
+    z_drop(z_move(enc));
+
+    return res;
+}
+
+auto client_t::start_outbox() //
+    -> void
+{
+    if (!_outbox || !is_connected()) {
+        return;
+    }
+    _outbox->start(
+        [this](
+            std::string_view key,
+            std::string_view value,
+            std::string_view encoding,
+            std::uint64_t unix_time) {
+            auto enc = z_owned_encoding_t{};
+            z_encoding_from_substr(&enc, encoding.data(), encoding.size());
+            auto bytes = z_owned_bytes_t{};
+            z_bytes_copy_from_buf(
+                &bytes,
+                reinterpret_cast<const uint8_t*>(value.data()),
+                value.size());
+            /* keep the time the sample was published originally */
+            auto timestamp = z_timestamp_t{};
+            z_timestamp_new(&timestamp, z_loan(*_z_session));
+            timestamp.time = unix_time_to_ntp64(unix_time);
+            return do_put(std::string{key}, enc, bytes, &timestamp);
+        },
+        [this]() { return is_online(); });
 }
 
-auto client_t::do_subscribe(
-    flunder::client_t* client,
-    std::string_view topic,
-    subscribe_cbk_var_t cbk,
-    const void* userp) //
+auto client_t::enable_outbox(outbox_options_t options) //
     -> int
 {
-    if (!is_connected()) {
+    if (_outbox) {
         return -1;
     }
 
-    const char* topic_str = topic.starts_with('/') ? topic.data() + 1 : topic.data();
-    if (_subscriptions.contains(topic_str)) {
+    auto outbox = std::make_unique<outbox_t>(std::move(options));
+    if (outbox->open() != 0) {
         return -1;
     }
+    _outbox = std::move(outbox);
+    start_outbox();
 
-    auto keyexpr = z_view_keyexpr_t{};
-    z_view_keyexpr_from_str(&keyexpr, topic_str);
+    return 0;
+}
+
+auto client_t::disable_outbox() //
+    -> int
+{
+    if (!_outbox) {
+        return -1;
+    }
+    _outbox.reset();
+
+    return 0;
+}
+
+auto client_t::outbox_stats() const //
+    -> outbox_stats_t
+{
+    return _outbox ? _outbox->stats() : outbox_stats_t{};
+}
+
+auto client_t::subscribe(
+    flunder::client_t* client,
+    std::string_view topic,
+    client_t::subscribe_cbk_t cbk) //
+    -> int
+{
+    return do_subscribe(client, topic, subscribe_cbk_var_t{std::move(cbk)}, nullptr);
+}
+
+auto client_t::subscribe(
+    flunder::client_t* client,
+    std::string_view topic,
+    client_t::subscribe_cbk_userp_t cbk,
+    const void* userp) //
+    -> int
+{
+    return do_subscribe(client, topic, subscribe_cbk_var_t{std::move(cbk)}, userp);
+}
+
+auto client_t::subscribe(
+    flunder::client_t* client,
+    std::string_view topic,
+    subscribe_delegate_t delegate) //
+    -> int
+{
+    auto cbk = bound_cbk_t{delegate.invoke, {delegate.obj, delegate.destroy}};
+    return do_subscribe(client, topic, subscribe_cbk_var_t{std::move(cbk)}, nullptr);
+}
+
+auto client_t::subscribe_batch(
+    flunder::client_t* client,
+    std::string_view topic,
+    subscribe_batch_cbk_t cbk,
+    batch_options_t options) //
+    -> int
+{
+    return do_subscribe(
+        client,
+        topic,
+        subscribe_cbk_var_t{},
+        nullptr,
+        std::make_unique<batch_t>(client, std::move(cbk), options, &_batch_flusher));
+}
+
+auto client_t::do_subscribe(
+    flunder::client_t* client,
+    std::string_view topic,
+    subscribe_cbk_var_t cbk,
+    const void* userp,
+    std::unique_ptr<batch_t> batch) //
+    -> int
+{
+    /* while connect_async is in progress, the subscription is declared by the connector */
+    auto lock = std::unique_lock{_connect_mutex, std::defer_lock};
+    if (!is_connected()) {
+        lock.lock();
+        if (_state.load() != connection_state_t::connecting) {
+            return -1;
+        }
+    }
 
-    auto res = _subscriptions.emplace(topic_str, subscribe_ctx_t{client, {}, cbk, userp, false});
+    const char* topic_str = topic.starts_with('/') ? topic.data() + 1 : topic.data();
+    if (_subscriptions.contains(topic_str)) {
+        return -1;
+    }
+
+    auto res = _subscriptions.emplace(
+        topic_str,
+        subscribe_ctx_t{client, {}, std::move(cbk), userp, false, std::move(batch)});
     if (!res.second) {
         return -1;
     }
     auto& ctx = res.first->second;
+    z_internal_null(&ctx._sub);
+    if (lock.owns_lock()) {
+        return 0;
+    }
+
+    const auto subscribe_res = declare_subscriber(res.first->first, ctx);
+    if (subscribe_res < 0) {
+        _subscriptions.erase(res.first);
+        return subscribe_res;
+    }
+    initial_get(res.first->first, ctx);
+
+    return 0;
+}
+
+auto client_t::initial_get(const std::string& topic, subscribe_ctx_t& ctx) //
+    -> void
+{
+    if (ctx._batch) {
+        const auto [unused, vars] = get(topic);
+        ctx._batch->deliver(vars);
+    } else {
+        auto stream = get_stream_t{};
+        if (get_stream(query_t{topic}, FLUNDER_GET_DEPTH, stream) == 0) {
+            while (const auto var = stream.next()) {
+                invoke(ctx._cbk, ctx._client, var, ctx._userp);
+            }
+        }
+    }
+    ctx._once = true;
+}
+
+auto client_t::declare_subscriber(const std::string& topic, subscribe_ctx_t& ctx) //
+    -> int
+{
+    if (!_z_session) {
+        return -1;
+    }
+
+    auto keyexpr = z_view_keyexpr_t{};
+    z_view_keyexpr_from_str(&keyexpr, topic.c_str());
 
     auto options = z_subscriber_options_t{};
     z_subscriber_options_default(&options);
 
     auto closure = z_owned_closure_sample_t{};
     z_closure(&closure, lib_subscribe_callback, nullptr, &ctx);
-    const auto subscribe_res = z_declare_subscriber(
-        z_loan(_z_session),
+    return z_declare_subscriber(
+        z_loan(*_z_session),
         &ctx._sub,
         z_loan(keyexpr),
         z_move(closure),
         &options);
+}
 
-    if (subscribe_res < 0) {
-        _subscriptions.erase(res.first);
-        return subscribe_res;
-    }
+auto client_t::determine_connected_peer_count() const //
+    -> int
+{
+    auto lock = std::shared_lock{_session_mutex};
+    return _z_session ? connected_peer_count(*_z_session) : 0;
+}
 
-    const auto [unused, vars] = get(topic_str);
-    for (const auto& var : vars) {
-        std::visit(
-            overload{
-                // call callback without userdata
-                [&](client_t::subscribe_cbk_t cbk) { cbk(ctx._client, &var); },
-                // call callback with userdata
-                [&](client_t::subscribe_cbk_userp_t cbk) { cbk(ctx._client, &var, ctx._userp); }},
-            ctx._cbk);
+auto client_t::is_online() const //
+    -> bool
+{
+    if (determine_connected_router_count() > 0) {
+        return true;
     }
-    ctx._once = true;
-
-    return 0;
+    return _connect_options.mode == session_mode_t::peer && determine_connected_peer_count() > 0;
 }
 
 auto client_t::determine_connected_router_count() const //
     -> int
 {
-    int routers = 0;
-    auto lambda = [](const struct z_id_t*, void* counter) { *static_cast<int*>(counter) += 1; };
-
-    auto callback = z_owned_closure_zid_t{};
-    z_closure(&callback, lambda, nullptr, &routers);
-    if (z_info_routers_zid(
-            z_session_loan(&_z_session),
-            reinterpret_cast<z_moved_closure_zid_t*>(&callback)) != 0) {
-        return 0;
-    }
-    return routers;
+    auto lock = std::shared_lock{_session_mutex};
+    return _z_session ? connected_router_count(*_z_session) : 0;
 }
 
 auto client_t::unsubscribe(std::string_view topic) //
     -> int
 {
+    auto lock = std::unique_lock{_connect_mutex, std::defer_lock};
+    if (!is_connected()) {
+        lock.lock();
+    }
+
     const auto keyexpr = topic.starts_with('/') ? topic.data() + 1 : topic.data();
 
     auto it = _subscriptions.find(keyexpr);
@@ -420,12 +1183,89 @@ auto client_t::unsubscribe(std::string_view topic) //
         return -1;
     }
 
-    z_undeclare_subscriber(z_move(it->second._sub));
+    if (z_internal_check(it->second._sub)) {
+        z_undeclare_subscriber(z_move(it->second._sub));
+    }
     _subscriptions.erase(it);
 
     return 0;
 }
 
+static auto lib_serve_callback(z_loaned_query_t* query, void* arg) //
+    -> void
+{
+    const auto ctx = static_cast<const client_t::serve_ctx_t*>(arg);
+    auto reply = reply_builder_t{query, ctx->_session};
+    ctx->_cbk(reply);
+}
+
+auto client_t::serve(std::string_view key_expr, serve_cbk_t cbk) //
+    -> int
+{
+    if (!is_connected()) {
+        return -1;
+    }
+
+    const char* keyexpr_str = key_expr.starts_with('/') ? key_expr.data() + 1 : key_expr.data();
+    if (_queryables.contains(keyexpr_str)) {
+        return -1;
+    }
+
+    auto keyexpr = z_view_keyexpr_t{};
+    if (z_view_keyexpr_from_str(&keyexpr, keyexpr_str) != 0) {
+        return -1;
+    }
+
+    auto res = _queryables.emplace(keyexpr_str, serve_ctx_t{nullptr, {}, std::move(cbk)});
+    const auto serve_res = declare_queryable(res.first->first, res.first->second);
+    if (serve_res < 0) {
+        _queryables.erase(res.first);
+        return serve_res;
+    }
+
+    return 0;
+}
+
+auto client_t::declare_queryable(const std::string& key_expr, serve_ctx_t& ctx) //
+    -> int
+{
+    if (!_z_session) {
+        return -1;
+    }
+
+    auto keyexpr = z_view_keyexpr_t{};
+    z_view_keyexpr_from_str(&keyexpr, key_expr.c_str());
+
+    auto options = z_queryable_options_t{};
+    z_queryable_options_default(&options);
+
+    auto closure = z_owned_closure_query_t{};
+    z_closure(&closure, lib_serve_callback, nullptr, &ctx);
+    ctx._session = _z_session.get();
+    return z_declare_queryable(
+        z_loan(*_z_session),
+        &ctx._queryable,
+        z_loan(keyexpr),
+        z_move(closure),
+        &options);
+}
+
+auto client_t::unserve(std::string_view key_expr) //
+    -> int
+{
+    const auto keyexpr = key_expr.starts_with('/') ? key_expr.data() + 1 : key_expr.data();
+
+    auto it = _queryables.find(keyexpr);
+    if (it == _queryables.cend()) {
+        return -1;
+    }
+
+    z_undeclare_queryable(z_move(it->second._queryable));
+    _queryables.erase(it);
+
+    return 0;
+}
+
 static auto router_zid(const z_id_t* zid, void* ctx) //
     -> void
 {
@@ -444,32 +1284,26 @@ auto client_t::add_mem_storage(
         return -1;
     }
 
-    if (_mem_storages.contains(mem_storage_t{name, {}})) {
+    auto lock = std::lock_guard{_mem_storages_mutex};
+
+    if (_mem_storages.contains(mem_storage_t{name, {}, {}})) {
         return -1;
     }
 
-    auto zid = std::string(32, '0');
-    {
-        auto cbk = z_owned_closure_zid_t{};
-        z_closure(&cbk, router_zid, nullptr, reinterpret_cast<void*>(&zid));
-        const auto res = z_info_routers_zid(z_loan(_z_session), z_move(cbk));
-        if (res != 0) {
-            return -1;
-        }
+    auto zid = std::string{};
+    if (connected_router_zid(zid) != 0) {
+        return -1;
     }
 
-    const auto keyexpr = topic.starts_with('/') ? topic.data() + 1 : topic.data();
-
-    const auto req = nlohmann::json({{"key_expr", keyexpr}, {"volume", "memory"}}).dump();
-    const auto admin_keyexpr =
-        ("@/" + zid + "/router/config/plugins/storage_manager/storages/").append(name);
-
-    const auto res = publish_custom(admin_keyexpr, req.data(), req.size(), "application/json");
-    if (res != 0) {
+    auto storage = mem_storage_t{
+        std::move(name),
+        std::string{topic.starts_with('/') ? topic.substr(1) : topic},
+        std::move(zid)};
+    if (put_mem_storage(storage) != 0) {
         return -1;
     }
 
-    _mem_storages.insert(mem_storage_t{std::move(name), std::move(zid)});
+    _mem_storages.insert(std::move(storage));
 
     return 0;
 }
@@ -477,7 +1311,13 @@ auto client_t::add_mem_storage(
 auto client_t::remove_mem_storage(std::string name) //
     -> int
 {
-    const auto it = _mem_storages.find(mem_storage_t{name, {}});
+    if (!_z_session) {
+        return -1;
+    }
+
+    auto lock = std::lock_guard{_mem_storages_mutex};
+
+    const auto it = _mem_storages.find(mem_storage_t{name, {}, {}});
     if (it == _mem_storages.end()) {
         return -1;
     }
@@ -490,95 +1330,418 @@ auto client_t::remove_mem_storage(std::string name) //
 
     auto opts = z_delete_options_t{};
     z_delete_options_default(&opts);
-    const auto res = z_delete(z_loan(_z_session), z_loan(keyexpr), &opts);
+    const auto res = z_delete(z_loan(*_z_session), z_loan(keyexpr), &opts);
 
     if (res != 0) {
         return -1;
     }
 
-    _mem_storages.erase(mem_storage_t{std::move(name), {}});
+    _mem_storages.erase(it);
+
+    return 0;
+}
+
+auto client_t::connected_router_zid(std::string& zid) const //
+    -> int
+{
+    if (!_z_session) {
+        return -1;
+    }
+
+    zid.assign(32, '0');
+    auto cbk = z_owned_closure_zid_t{};
+    z_closure(&cbk, router_zid, nullptr, reinterpret_cast<void*>(&zid));
+    return (z_info_routers_zid(z_loan(*_z_session), z_move(cbk)) == 0) ? 0 : -1;
+}
+
+auto client_t::put_mem_storage(const mem_storage_t& storage) const //
+    -> int
+{
+    const auto req =
+        nlohmann::json({{"key_expr", storage.key_expr}, {"volume", "memory"}}).dump();
+    const auto admin_keyexpr =
+        ("@/" + storage.zid + "/router/config/plugins/storage_manager/storages/")
+            .append(storage.name);
+
+    return publish_custom(admin_keyexpr, req.data(), req.size(), "application/json");
+}
+
+auto client_t::restore_mem_storages() //
+    -> void
+{
+    auto zid = std::string{};
+    if (connected_router_zid(zid) != 0) {
+        return;
+    }
+
+    /* storages are configured on the router; a restarted or different router has lost them */
+    auto lock = std::lock_guard{_mem_storages_mutex};
+    auto restored = std::set<mem_storage_t>{};
+    for (auto storage : _mem_storages) {
+        if (storage.zid != zid) {
+            storage.zid = zid;
+            put_mem_storage(storage);
+        }
+        restored.insert(std::move(storage));
+    }
+    _mem_storages.swap(restored);
+}
+
+auto client_t::add_local_storage(
+    std::string name, std::string_view key_expr, local_storage_options_t options) //
+    -> int
+{
+    if (!is_connected()) {
+        return -1;
+    }
+    if (_local_storages.contains(name)) {
+        return -1;
+    }
+
+    auto storage = std::make_unique<local_storage_t>(
+        std::string{key_expr.starts_with('/') ? key_expr.substr(1) : key_expr},
+        std::move(options));
+    if (storage->declare(_z_session.get()) != 0) {
+        return -1;
+    }
+
+    _local_storages.emplace(std::move(name), std::move(storage));
 
     return 0;
 }
 
+auto client_t::remove_local_storage(std::string name) //
+    -> int
+{
+    return (_local_storages.erase(name) == 1) ? 0 : -1;
+}
+
 auto client_t::get(std::string_view topic) const //
     -> std::tuple<int, std::vector<variable_t>>
+{
+    return get(query_t{topic});
+}
+
+auto client_t::get(const query_t& query) const //
+    -> std::tuple<int, std::vector<variable_t>>
 {
     auto vars = std::vector<variable_t>{};
 
+    auto stream = get_stream_t{};
+    const auto res = get_stream(query, FLUNDER_GET_DEPTH, stream);
+    if (res != 0) {
+        return {res, vars};
+    }
+
+    while (const auto var = stream.next()) {
+        vars.emplace_back(*var);
+    }
+
+    return {stream.timed_out() ? -ETIMEDOUT : 0, vars};
+}
+
+/* replies retained by a zero-copy result set; a deque keeps them in place while growing */
+struct retained_replies_t
+{
+    ~retained_replies_t()
+    {
+        for (auto& reply : replies) {
+            z_drop(z_move(reply));
+        }
+    }
+
+    std::deque<z_owned_reply_t> replies;
+};
+
+auto client_t::get_result_set(const query_t& query, result_mode_t mode) const //
+    -> std::tuple<int, result_set_t>
+{
+    auto results = result_set_t{};
+
+    auto stream = get_stream_t{};
+    const auto res = get_stream(query, FLUNDER_GET_DEPTH, stream);
+    if (res != 0) {
+        return {res, std::move(results)};
+    }
+
+    /* ordered queries sort owned copies anyway */
+    if (mode == result_mode_t::copy || query.is_ordered()) {
+        while (const auto var = stream.next()) {
+            results.push_back(*var);
+        }
+        return {stream.timed_out() ? -ETIMEDOUT : 0, std::move(results)};
+    }
+
+    auto* retained = new retained_replies_t{};
+    results.retain({retained, [](void* p) { delete static_cast<retained_replies_t*>(p); }});
+    auto buffers = sample_buffers_t{};
+    auto fragmented = std::string{};
+    while (true) {
+        auto& reply = retained->replies.emplace_back();
+        z_internal_null(&reply);
+        if (!stream.next_reply(reply)) {
+            retained->replies.pop_back();
+            break;
+        }
+
+        const auto sample = z_reply_ok(z_loan(reply));
+        /* formats encoding and timestamp; topic and value are borrowed from the reply */
+        const auto var = to_variable(sample, buffers, false);
+        auto keyexpr = z_view_string_t{};
+        z_keyexpr_as_view_string(z_sample_keyexpr(sample), &keyexpr);
+        const auto topic =
+            std::string_view{z_string_data(z_loan(keyexpr)), z_string_len(z_loan(keyexpr))};
+
+        auto value = std::string_view{};
+        if (!query.is_keys_only()) {
+            const auto payload = z_sample_payload(sample);
+            auto slice = z_view_slice_t{};
+            if (z_bytes_get_contiguous_view(payload, &slice) == Z_OK) {
+                value = std::string_view{
+                    reinterpret_cast<const char*>(z_slice_data(z_loan(slice))),
+                    z_slice_len(z_loan(slice))};
+            } else {
+                /* fragmented payloads have no single slice to borrow */
+                auto reader = z_bytes_get_reader(payload);
+                fragmented.resize(z_bytes_reader_remaining(&reader));
+                z_bytes_reader_read(
+                    &reader,
+                    reinterpret_cast<uint8_t*>(fragmented.data()),
+                    fragmented.size());
+                value = results.store(fragmented);
+            }
+        }
+        results.push_back_borrowed(topic, value, var.encoding(), var.timestamp());
+    }
+
+    return {stream.timed_out() ? -ETIMEDOUT : 0, std::move(results)};
+}
+
+auto client_t::get_columns(const query_t& query) const //
+    -> std::tuple<int, column_set_t>
+{
+    auto columns = column_set_t{};
+
+    auto stream = get_stream_t{};
+    const auto res = get_stream(query, FLUNDER_GET_DEPTH, stream);
+    if (res != 0) {
+        return {res, std::move(columns)};
+    }
+
+    while (const auto var = stream.next()) {
+        columns.push_back(*var);
+    }
+
+    return {stream.timed_out() ? -ETIMEDOUT : 0, std::move(columns)};
+}
+
+auto client_t::get_many(
+    std::span<const std::string_view> topics,
+    std::chrono::milliseconds timeout) const //
+    -> std::tuple<int, std::vector<std::vector<variable_t>>>
+{
     if (!is_connected()) {
-        return {-1, vars};
+        return {-1, std::vector<std::vector<variable_t>>(topics.size())};
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    auto ctx = std::make_shared<get_many_ctx_t>();
+    ctx->_results.resize(topics.size());
+    ctx->_pending = topics.size();
+    ctx->_abandoned = false;
+
+    auto session_lock = std::shared_lock{_session_mutex};
+    if (!_z_session) {
+        return {-1, std::vector<std::vector<variable_t>>(topics.size())};
+    }
+
+    /* queries that cannot be issued are reported, but do not keep the others from completing */
+    auto res = 0;
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+        const auto topic = topics[i].starts_with('/') ? topics[i].substr(1) : topics[i];
+
+        auto keyexpr = z_view_keyexpr_t{};
+        if (z_view_keyexpr_from_substr(&keyexpr, topic.data(), topic.size()) < 0) {
+            auto lock = std::lock_guard{ctx->_mutex};
+            --ctx->_pending;
+            res = -EINVAL;
+            continue;
+        }
+
+        auto options = z_get_options_t{};
+        z_get_options_default(&options);
+        options.target = Z_QUERY_TARGET_ALL;
+        options.timeout_ms = static_cast<std::uint64_t>(std::max<std::int64_t>(timeout.count(), 1));
+
+        /* the closure is dropped and the query accounted for even if z_get fails */
+        auto closure = z_owned_closure_reply_t{};
+        z_closure(
+            &closure,
+            lib_get_many_reply_callback,
+            lib_get_many_drop_callback,
+            new get_many_query_t{ctx, i});
+        if (z_get(z_loan(*_z_session), z_loan(keyexpr), "", z_move(closure), &options) != 0 &&
+            res == 0) {
+            res = -1;
+        }
+    }
+    session_lock.unlock();
+
+    auto lock = std::unique_lock{ctx->_mutex};
+    const auto complete = ctx->_cv.wait_until(lock, deadline, [&ctx] { return ctx->_pending == 0; });
+    ctx->_abandoned = true;
+    if (res == 0 && !complete) {
+        res = -ETIMEDOUT;
+    }
+
+    return {res, std::move(ctx->_results)};
+}
+
+static auto to_z_query_target(query_target_t target) //
+    -> z_query_target_t
+{
+    switch (target) {
+        case query_target_t::best_matching:
+            return Z_QUERY_TARGET_BEST_MATCHING;
+        case query_target_t::all_complete:
+            return Z_QUERY_TARGET_ALL_COMPLETE;
+        case query_target_t::all:
+        default:
+            return Z_QUERY_TARGET_ALL;
+    }
+}
+
+static auto to_z_consolidation(consolidation_t consolidation) //
+    -> z_query_consolidation_t
+{
+    switch (consolidation) {
+        case consolidation_t::none:
+            return z_query_consolidation_none();
+        case consolidation_t::monotonic:
+            return z_query_consolidation_monotonic();
+        case consolidation_t::latest:
+            return z_query_consolidation_latest();
+        case consolidation_t::automatic:
+        default:
+            return z_query_consolidation_auto();
+    }
+}
+
+auto client_t::get_stream(const query_t& query, std::size_t depth, get_stream_t& stream) const //
+    -> int
+{
+    if (!is_connected()) {
+        return -1;
     }
 
     auto keyexpr = z_view_keyexpr_t{};
-    const auto res =
-        z_view_keyexpr_from_str(&keyexpr, topic.starts_with('/') ? topic.data() + 1 : topic.data());
+    const auto res = z_view_keyexpr_from_str(&keyexpr, query.topic().data());
     if (res < 0) {
-        return {res, vars};
+        return res;
     }
 
     auto options = z_get_options_t{};
     z_get_options_default(&options);
-    options.target = Z_QUERY_TARGET_ALL;
+    options.target = to_z_query_target(query.target());
+    options.consolidation = to_z_consolidation(query.consolidation());
+    if (query.timeout().count() > 0) {
+        options.timeout_ms = static_cast<std::uint64_t>(query.timeout().count());
+    }
 
-    auto handler = z_owned_fifo_handler_reply_t{};
-    auto closure = z_owned_closure_reply_t{};
-    z_fifo_channel_reply_new(&closure, &handler, 64);
+    const auto parameters = query.parameters();
+    auto lock = std::shared_lock{_session_mutex};
+    if (!_z_session) {
+        return -1;
+    }
+    auto closure = stream.open(depth, query.limit(), query.is_ordered(), query.is_keys_only());
+    const auto get_res =
+        z_get(z_loan(*_z_session), z_loan(keyexpr), parameters.c_str(), z_move(closure), &options);
+    if (get_res != 0) {
+        stream.cancel();
+        return -1;
+    }
 
-    z_get(z_loan(_z_session), z_loan(keyexpr), "", z_move(closure), &options);
+    return 0;
+}
 
-    auto reply = z_owned_reply_t{};
-    for (z_result_t res = z_recv(z_loan(handler), &reply); res == Z_OK;
-         res = z_recv(z_loan(handler), &reply)) {
-        if (z_reply_is_ok(z_loan(reply))) {
-            const auto sample = z_reply_ok(z_loan(reply));
+auto client_t::get_async(std::string_view topic, get_cbk_t cbk) const //
+    -> void
+{
+    if (!is_connected()) {
+        return cbk(-1, {});
+    }
 
-            auto keyexpr = z_view_string_t{};
-            z_keyexpr_as_view_string(z_sample_keyexpr(sample), &keyexpr);
+    auto keyexpr = z_view_keyexpr_t{};
+    const auto res =
+        z_view_keyexpr_from_str(&keyexpr, topic.starts_with('/') ? topic.data() + 1 : topic.data());
+    if (res < 0) {
+        return cbk(res, {});
+    }
 
-            auto keystr =
-                std::string{z_string_data(z_loan(keyexpr)), z_string_len(z_loan(keyexpr))};
-            if (keystr.starts_with("@")) {
-                continue;
-            }
+    auto options = z_get_options_t{};
+    z_get_options_default(&options);
+    options.target = Z_QUERY_TARGET_ALL;
 
-            auto payload_reader = z_bytes_get_reader(z_sample_payload(sample));
-            auto payload_len = z_bytes_reader_remaining(&payload_reader);
-            auto payload = std::string(payload_len, '\0');
-            z_bytes_reader_read(
-                &payload_reader,
-                reinterpret_cast<uint8_t*>(payload.data()),
-                payload_len);
-
-            vars.emplace_back(
-                std::move(keystr),
-                std::move(payload),
-                to_string(z_sample_encoding(sample)),
-                flunder::to_string(
-                    ntp64_to_unix_time(z_timestamp_ntp64_time(z_sample_timestamp(sample)))));
-        }
-        z_drop(z_move(reply));
+    auto lock = std::shared_lock{_session_mutex};
+    if (!_z_session) {
+        return cbk(-1, {});
     }
 
-    z_drop(z_move(handler));
+    auto ctx = new get_async_ctx_t{std::move(cbk), {}, 2, 0};
+
+    auto closure = z_owned_closure_reply_t{};
+    z_closure(&closure, lib_get_reply_callback, lib_get_drop_callback, ctx);
 
-    return {0, vars};
+    ctx->_res = (z_get(z_loan(*_z_session), z_loan(keyexpr), "", z_move(closure), &options) == 0)
+                    ? 0
+                    : -1;
+    ctx->release();
 }
 
 auto client_t::erase(std::string_view topic) //
     -> int
 {
+    if (!is_connected()) {
+        return -1;
+    }
+
     auto keyexpr = z_view_keyexpr_t{};
     z_view_keyexpr_from_str(&keyexpr, topic.starts_with('/') ? topic.data() + 1 : topic.data());
 
     auto options = z_delete_options_t{};
     z_delete_options_default(&options);
 
-    const auto res = z_delete(z_loan(_z_session), z_loan(keyexpr), &options);
+    auto lock = std::shared_lock{_session_mutex};
+    if (!_z_session) {
+        return -1;
+    }
+    const auto res = z_delete(z_loan(*_z_session), z_loan(keyexpr), &options);
 
     return res;
 }
 
+auto client_t::set_executor(executor_t executor) //
+    -> void
+{
+    _executor = std::move(executor);
+}
+
+auto client_t::executor() const noexcept //
+    -> const executor_t&
+{
+    return _executor;
+}
+
+auto client_t::callback_executor() const //
+    -> executor_t
+{
+    if (_executor) {
+        return _executor;
+    }
+    return [this](std::coroutine_handle<> handle) { _resume_thread.post(handle); };
+}
+
 auto to_string(const z_loaned_encoding_t* encoding) //
     -> std::string
 {
@@ -591,6 +1754,55 @@ auto to_string(const z_loaned_encoding_t* encoding) //
     return str;
 }
 
+auto to_variable(const z_loaned_sample_t* sample) //
+    -> variable_t
+{
+    /* the buffers are reused, so the variable owning a copy is the only allocation. Nothing runs
+     * between filling them and copying, so nested calls on the same thread cannot interfere. */
+    thread_local auto buffers = sample_buffers_t{};
+    auto var = to_variable(sample, buffers);
+    var.own();
+    return var;
+}
+
+auto to_variable(const z_loaned_sample_t* sample, sample_buffers_t& buffers, bool payload) //
+    -> variable_t
+{
+    auto keyexpr = z_view_string_t{};
+    z_keyexpr_as_view_string(z_sample_keyexpr(sample), &keyexpr);
+    buffers.topic.assign(z_string_data(z_loan(keyexpr)), z_string_len(z_loan(keyexpr)));
+
+    if (payload) {
+        auto payload_reader = z_bytes_get_reader(z_sample_payload(sample));
+        buffers.value.resize(z_bytes_reader_remaining(&payload_reader));
+        z_bytes_reader_read(
+            &payload_reader,
+            reinterpret_cast<uint8_t*>(buffers.value.data()),
+            buffers.value.size());
+    } else {
+        buffers.value.clear();
+    }
+
+    auto encoding = z_owned_string_t{};
+    z_encoding_to_string(z_sample_encoding(sample), &encoding);
+    buffers.encoding.assign(z_string_data(z_loan(encoding)), z_string_len(z_loan(encoding)));
+    z_drop(z_move(encoding));
+
+    const auto unix_time = ntp64_to_unix_time(z_timestamp_ntp64_time(z_sample_timestamp(sample)));
+    buffers.timestamp.resize(std::numeric_limits<std::uint64_t>::digits10 + 1);
+    const auto [end, ec] = std::to_chars(
+        buffers.timestamp.data(),
+        buffers.timestamp.data() + buffers.timestamp.size(),
+        unix_time);
+    buffers.timestamp.resize(end - buffers.timestamp.data());
+
+    return variable_t{
+        std::string_view{buffers.topic},
+        std::string_view{buffers.value},
+        std::string_view{buffers.encoding},
+        std::string_view{buffers.timestamp}};
+}
+
 auto ntp64_to_unix_time(std::uint64_t ntp_time) //
     -> uint64_t
 {
@@ -615,5 +1827,15 @@ auto ntp64_to_unix_time(std::uint64_t ntp_time) //
     return unix_time;
 }
 
+auto unix_time_to_ntp64(std::uint64_t unix_time) //
+    -> uint64_t
+{
+    const auto seconds = unix_time / 1'000'000'000;
+    const auto nanos = unix_time % 1'000'000'000;
+    const auto fractions = (nanos << 32) / 1'000'000'000;
+
+    return (seconds << 32) | fractions;
+}
+
 } // namespace impl
 } // namespace flunder
@@ -0,0 +1,210 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/get_stream.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string_view>
+
+namespace flunder {
+namespace impl {
+
+/* zenoh finishes queries running into their timeout with an error reply "Timeout" */
+static auto is_timeout(const z_loaned_reply_err_t* err) //
+    -> bool
+{
+    constexpr auto timeout = std::string_view{"Timeout"};
+
+    const auto payload = z_reply_err_payload(err);
+    if (z_bytes_len(payload) != timeout.size()) {
+        return false;
+    }
+    auto buf = std::array<char, timeout.size()>{};
+    auto reader = z_bytes_get_reader(payload);
+    z_bytes_reader_read(&reader, reinterpret_cast<uint8_t*>(buf.data()), buf.size());
+    return std::string_view{buf.data(), buf.size()} == timeout;
+}
+
+get_stream_t::get_stream_t()
+    : _handler{}
+    , _buffers{}
+    , _current{}
+    , _limit{}
+    , _delivered{}
+    , _ordered{}
+    , _keys_only{}
+    , _sorted_ready{}
+    , _timed_out{}
+    , _sorted{}
+{
+    z_internal_null(&_handler);
+}
+
+get_stream_t::~get_stream_t()
+{
+    cancel();
+}
+
+auto get_stream_t::open(std::size_t depth, std::size_t limit, bool ordered, bool keys_only) //
+    -> z_owned_closure_reply_t
+{
+    cancel();
+
+    _limit = limit;
+    _delivered = 0;
+    _ordered = ordered;
+    _keys_only = keys_only;
+    _sorted_ready = false;
+    _timed_out = false;
+    _sorted.clear();
+
+    auto closure = z_owned_closure_reply_t{};
+    z_fifo_channel_reply_new(&closure, &_handler, std::max<std::size_t>(depth, 1));
+    return closure;
+}
+
+auto get_stream_t::is_open() const noexcept //
+    -> bool
+{
+    return z_internal_check(_handler);
+}
+
+auto get_stream_t::next() //
+    -> const variable_t*
+{
+    if (_limit && _delivered == _limit) {
+        cancel();
+        return nullptr;
+    }
+
+    if (_ordered) {
+        if (!_sorted_ready) {
+            sort();
+        }
+        if (_delivered == _sorted.size()) {
+            _sorted.clear();
+            return nullptr;
+        }
+        return &_sorted[_delivered++].second;
+    }
+
+    if (!receive()) {
+        return nullptr;
+    }
+    ++_delivered;
+    return &_current;
+}
+
+auto get_stream_t::next_reply(z_owned_reply_t& reply) //
+    -> bool
+{
+    if (_limit && _delivered == _limit) {
+        cancel();
+        return false;
+    }
+
+    if (!receive_reply(reply)) {
+        return false;
+    }
+    ++_delivered;
+    return true;
+}
+
+auto get_stream_t::receive() //
+    -> bool
+{
+    auto reply = z_owned_reply_t{};
+    if (!receive_reply(reply)) {
+        return false;
+    }
+    _current = to_variable(z_reply_ok(z_loan(reply)), _buffers, !_keys_only);
+    z_drop(z_move(reply));
+    return true;
+}
+
+auto get_stream_t::receive_reply(z_owned_reply_t& reply) //
+    -> bool
+{
+    if (!is_open()) {
+        return false;
+    }
+
+    while (z_recv(z_loan(_handler), &reply) == Z_OK) {
+        if (z_reply_is_ok(z_loan(reply))) {
+            const auto sample = z_reply_ok(z_loan(reply));
+
+            auto keyexpr = z_view_string_t{};
+            z_keyexpr_as_view_string(z_sample_keyexpr(sample), &keyexpr);
+            if (z_string_len(z_loan(keyexpr)) == 0 || *z_string_data(z_loan(keyexpr)) != '@') {
+                return true;
+            }
+        } else if (is_timeout(z_reply_err(z_loan(reply)))) {
+            _timed_out = true;
+        }
+        z_drop(z_move(reply));
+    }
+
+    cancel();
+    return false;
+}
+
+auto get_stream_t::sort() //
+    -> void
+{
+    const auto older = [](const timed_variable_t& lhs, const timed_variable_t& rhs) {
+        return lhs.first < rhs.first;
+    };
+
+    while (receive()) {
+        auto timestamp = std::uint64_t{};
+        const auto ts = _current.timestamp();
+        std::from_chars(ts.data(), ts.data() + ts.size(), timestamp);
+
+        if (_limit && _sorted.size() == _limit) {
+            /* max-heap of the _limit oldest replies so far */
+            if (timestamp >= _sorted.front().first) {
+                continue;
+            }
+            std::pop_heap(_sorted.begin(), _sorted.end(), older);
+            _sorted.pop_back();
+        }
+        _sorted.emplace_back(timestamp, _current);
+        if (_limit) {
+            std::push_heap(_sorted.begin(), _sorted.end(), older);
+        }
+    }
+
+    std::stable_sort(_sorted.begin(), _sorted.end(), older);
+    _sorted_ready = true;
+}
+
+auto get_stream_t::cancel() //
+    -> void
+{
+    if (is_open()) {
+        z_drop(z_move(_handler));
+        z_internal_null(&_handler);
+    }
+}
+
+auto get_stream_t::timed_out() const noexcept //
+    -> bool
+{
+    return _timed_out;
+}
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,300 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/local_storage.h"
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+
+#include "flunder/impl/client.h"
+
+namespace flunder {
+namespace impl {
+
+local_storage_t::local_storage_t(std::string key_expr, local_storage_options_t options)
+    : _key_expr{std::move(key_expr)}
+    , _store{std::move(options)}
+    , _open{}
+    , _session{}
+    , _sub{}
+    , _queryable{}
+{
+    z_internal_null(&_sub);
+    z_internal_null(&_queryable);
+}
+
+local_storage_t::~local_storage_t()
+{
+    undeclare();
+}
+
+auto local_storage_t::declare(const z_owned_session_t* session) //
+    -> int
+{
+    if (!_open) {
+        if (_store.open() != 0) {
+            return -1;
+        }
+        _open = true;
+    }
+
+    auto keyexpr = z_view_keyexpr_t{};
+    if (z_view_keyexpr_from_str(&keyexpr, _key_expr.c_str()) != 0) {
+        return -1;
+    }
+    _session = session;
+
+    auto sub_options = z_subscriber_options_t{};
+    z_subscriber_options_default(&sub_options);
+    auto sample_closure = z_owned_closure_sample_t{};
+    z_closure(&sample_closure, on_sample, nullptr, this);
+    if (z_declare_subscriber(
+            z_loan(*_session),
+            &_sub,
+            z_loan(keyexpr),
+            z_move(sample_closure),
+            &sub_options) != 0) {
+        return -1;
+    }
+
+    auto queryable_options = z_queryable_options_t{};
+    z_queryable_options_default(&queryable_options);
+    auto query_closure = z_owned_closure_query_t{};
+    z_closure(&query_closure, on_query, nullptr, this);
+    if (z_declare_queryable(
+            z_loan(*_session),
+            &_queryable,
+            z_loan(keyexpr),
+            z_move(query_closure),
+            &queryable_options) != 0) {
+        undeclare();
+        return -1;
+    }
+
+    return 0;
+}
+
+auto local_storage_t::undeclare() //
+    -> void
+{
+    if (z_internal_check(_queryable)) {
+        z_undeclare_queryable(z_move(_queryable));
+        z_internal_null(&_queryable);
+    }
+    if (z_internal_check(_sub)) {
+        z_undeclare_subscriber(z_move(_sub));
+        z_internal_null(&_sub);
+    }
+    _store.sync();
+}
+
+auto local_storage_t::on_sample(z_loaned_sample_t* sample, void* arg) //
+    -> void
+{
+    auto* storage = static_cast<local_storage_t*>(arg);
+    if (z_sample_kind(sample) != Z_SAMPLE_KIND_PUT) {
+        return;
+    }
+
+    const auto ts = z_sample_timestamp(sample);
+    const auto timestamp = ts ? ntp64_to_unix_time(z_timestamp_ntp64_time(ts))
+                              : static_cast<std::uint64_t>(
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::system_clock::now().time_since_epoch())
+                                        .count());
+
+    thread_local auto buffers = sample_buffers_t{};
+    const auto var = to_variable(sample, buffers);
+    storage->_store.append(var.topic(), var.value(), var.encoding(), timestamp);
+}
+
+auto local_storage_t::on_query(z_loaned_query_t* query, void* arg) //
+    -> void
+{
+    auto* storage = static_cast<local_storage_t*>(arg);
+    auto reply = reply_builder_t{query, storage->_session};
+
+    const auto query_keyexpr = z_query_keyexpr(query);
+    const auto match = [query_keyexpr](std::string_view key) {
+        auto keyexpr = z_view_keyexpr_t{};
+        return z_view_keyexpr_from_substr(&keyexpr, key.data(), key.size()) == 0 &&
+               z_keyexpr_intersects(query_keyexpr, z_loan(keyexpr));
+    };
+    const auto visit = [&reply](const variable_t& var) { reply.reply(var); };
+
+    if (const auto range = parse_time_range(reply.parameters())) {
+        storage->_store.range(match, range->first, range->second, visit);
+    } else {
+        storage->_store.latest(match, visit);
+    }
+}
+
+/* nanoseconds since the Unix epoch of an RFC 3339 UTC time, e.g. 2023-11-14T22:13:20.5Z */
+static auto parse_rfc3339(std::string_view str) //
+    -> std::optional<std::uint64_t>
+{
+    auto tm = std::tm{};
+    auto consumed = 0;
+    const auto s = std::string{str};
+    if (std::sscanf(
+            s.c_str(),
+            "%4d-%2d-%2dT%2d:%2d:%2d%n",
+            &tm.tm_year,
+            &tm.tm_mon,
+            &tm.tm_mday,
+            &tm.tm_hour,
+            &tm.tm_min,
+            &tm.tm_sec,
+            &consumed) != 6) {
+        return std::nullopt;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+
+    auto rest = str.substr(consumed);
+    auto nanos = std::uint64_t{};
+    if (rest.starts_with('.')) {
+        rest.remove_prefix(1);
+        auto digits = std::size_t{};
+        while (digits < rest.size() && rest[digits] >= '0' && rest[digits] <= '9') {
+            if (digits < 9) {
+                nanos = nanos * 10 + (rest[digits] - '0');
+            }
+            ++digits;
+        }
+        for (auto i = digits; i < 9; ++i) {
+            nanos *= 10;
+        }
+        rest.remove_prefix(digits);
+    }
+    if (rest != "Z") {
+        return std::nullopt;
+    }
+
+    const auto seconds = timegm(&tm);
+    if (seconds < 0) {
+        return std::nullopt;
+    }
+    return static_cast<std::uint64_t>(seconds) * 1'000'000'000 + nanos;
+}
+
+/* nanoseconds since the Unix epoch of now() or now(<offset>), e.g. now(-1.5h) */
+static auto parse_now(std::string_view str) //
+    -> std::optional<std::uint64_t>
+{
+    if (!str.starts_with("now(") || !str.ends_with(')')) {
+        return std::nullopt;
+    }
+    str = str.substr(4, str.size() - 5);
+
+    const auto now = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::system_clock::now().time_since_epoch())
+                                             .count());
+    if (str.empty()) {
+        return static_cast<std::uint64_t>(now);
+    }
+
+    auto offset = double{};
+    const auto [unit, ec] = std::from_chars(str.data(), str.data() + str.size(), offset);
+    if (ec != std::errc{}) {
+        return std::nullopt;
+    }
+
+    constexpr auto units = std::array<std::pair<std::string_view, double>, 7>{{
+        {"u", 1e3},
+        {"ms", 1e6},
+        {"s", 1e9},
+        {"m", 60e9},
+        {"h", 3600e9},
+        {"d", 86400e9},
+        {"w", 604800e9},
+    }};
+    const auto suffix = std::string_view{unit, str.data() + str.size()};
+    for (const auto& [name, factor] : units) {
+        if (suffix == name) {
+            const auto time = now + offset * factor;
+            return time < 0 ? 0 : static_cast<std::uint64_t>(time);
+        }
+    }
+    return std::nullopt;
+}
+
+static auto parse_bound(std::string_view str, std::uint64_t unbounded) //
+    -> std::optional<std::uint64_t>
+{
+    if (str.empty()) {
+        return unbounded;
+    }
+    if (str.starts_with("now(")) {
+        return parse_now(str);
+    }
+    return parse_rfc3339(str);
+}
+
+auto parse_time_range(std::string_view parameters) //
+    -> std::optional<std::pair<std::uint64_t, std::uint64_t>>
+{
+    auto expr = std::string_view{};
+    while (!parameters.empty()) {
+        const auto sep = parameters.find(';');
+        const auto param = parameters.substr(0, sep);
+        if (param.starts_with("_time=")) {
+            expr = param.substr(6);
+        }
+        parameters =
+            (sep == std::string_view::npos) ? std::string_view{} : parameters.substr(sep + 1);
+    }
+
+    if (expr.size() < 4 || (expr.front() != '[' && expr.front() != ']') ||
+        (expr.back() != ']' && expr.back() != '[')) {
+        return std::nullopt;
+    }
+    /* "]start.." and "..end[" exclude their bound */
+    const auto exclude_start = expr.front() == ']';
+    const auto exclude_end = expr.back() == '[';
+    expr = expr.substr(1, expr.size() - 2);
+
+    const auto dots = expr.find("..");
+    if (dots == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const auto start_expr = expr.substr(0, dots);
+    const auto end_expr = expr.substr(dots + 2);
+    auto start = parse_bound(start_expr, 0);
+    auto end = parse_bound(end_expr, std::numeric_limits<std::uint64_t>::max());
+    if (!start || !end) {
+        return std::nullopt;
+    }
+    /* unbounded sides have nothing to exclude */
+    if (exclude_start && !start_expr.empty()) {
+        if (*start == std::numeric_limits<std::uint64_t>::max()) {
+            return std::nullopt;
+        }
+        ++*start;
+    }
+    if (exclude_end && !end_expr.empty()) {
+        if (*end == 0) {
+            return std::nullopt;
+        }
+        --*end;
+    }
+    return std::make_pair(*start, *end);
+}
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,424 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/outbox.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+#include "flunder/impl/segment_store.h"
+
+namespace flunder {
+namespace impl {
+
+namespace {
+
+//  outbox file
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | magic "FLOB"                      | version                           |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | head: offset of the oldest record                                     |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | tail: offset of the next record                                       |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | count: number of records                                              |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | records in [head, tail), wrapping around to DATA_START ...            |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+//
+// A record that does not fit before the end of the file starts over at DATA_START; a size of 0
+// marks the skipped space.
+struct outbox_header_t
+{
+    std::array<char, 4> magic;
+    std::uint32_t version;
+    std::uint64_t head;
+    std::uint64_t tail;
+    std::uint64_t count;
+};
+
+constexpr auto OUTBOX_MAGIC = std::array<char, 4>{'F', 'L', 'O', 'B'};
+constexpr auto OUTBOX_VERSION = std::uint32_t{1};
+constexpr auto DATA_START = std::size_t{64};
+
+/* how often the replay thread checks for a router and writes buffered records to disk */
+constexpr auto CHECK_INTERVAL = std::chrono::milliseconds{100};
+
+auto header_of(char* base) //
+    -> outbox_header_t&
+{
+    return *reinterpret_cast<outbox_header_t*>(base);
+}
+
+auto header_of(const char* base) //
+    -> const outbox_header_t&
+{
+    return *reinterpret_cast<const outbox_header_t*>(base);
+}
+
+} // namespace
+
+outbox_t::outbox_t(outbox_options_t options)
+    : _options{std::move(options)}
+    , _fd{-1}
+    , _base{}
+    , _capacity{}
+    , _head_seqno{}
+    , _online{}
+    , _pending{}
+    , _buffered{}
+    , _replayed{}
+    , _discarded{}
+    , _publish{}
+    , _is_online{}
+    , _stop{}
+    , _thread{}
+    , _cv{}
+    , _replay_mutex{}
+    , _mutex{}
+{}
+
+outbox_t::~outbox_t()
+{
+    {
+        auto lock = std::lock_guard{_replay_mutex};
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_base) {
+        ::msync(_base, _capacity, MS_SYNC);
+        ::munmap(_base, _capacity);
+    }
+    if (_fd != -1) {
+        ::close(_fd);
+    }
+}
+
+auto outbox_t::open() //
+    -> int
+{
+    auto lock = std::lock_guard{_mutex};
+
+    _fd = ::open(_options.path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd == -1) {
+        return -1;
+    }
+
+    /* an existing outbox keeps its size, so records buffered by a previous run are not lost */
+    struct stat st = {};
+    if (::fstat(_fd, &st) != 0) {
+        return -1;
+    }
+    _capacity = static_cast<std::size_t>(st.st_size);
+    auto header = outbox_header_t{};
+    auto valid = false;
+    if (_capacity >= DATA_START + record_size(0, 0, 0) && _capacity % RECORD_ALIGN == 0 &&
+        ::pread(_fd, &header, sizeof(header), 0) == sizeof(header)) {
+        valid = (header.magic == OUTBOX_MAGIC && header.version == OUTBOX_VERSION);
+    }
+    if (!valid) {
+        _capacity = std::max(_options.max_size, DATA_START + record_size(0, 0, 0));
+        _capacity &= ~(RECORD_ALIGN - 1);
+        if (::ftruncate(_fd, 0) != 0 || ::ftruncate(_fd, static_cast<off_t>(_capacity)) != 0) {
+            return -1;
+        }
+    }
+
+    const auto base = ::mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    _base = static_cast<char*>(base);
+
+    if (valid) {
+        recover();
+    } else {
+        header = outbox_header_t{OUTBOX_MAGIC, OUTBOX_VERSION, DATA_START, DATA_START, 0};
+        std::memcpy(_base, &header, sizeof(header));
+    }
+    _pending = header_of(_base).count;
+
+    _thread = std::thread{&outbox_t::replay, this};
+
+    return 0;
+}
+
+auto outbox_t::recover() //
+    -> void
+{
+    auto& header = header_of(_base);
+    if (header.head < DATA_START || header.head >= _capacity || header.head % RECORD_ALIGN != 0) {
+        header.head = DATA_START;
+        header.tail = DATA_START;
+        header.count = 0;
+        return;
+    }
+
+    /* walk the ring from the oldest record, cutting it at the first corrupt record */
+    auto size = std::uint32_t{};
+    std::memcpy(&size, _base + header.head, sizeof(size));
+    if (size == 0) {
+        header.head = DATA_START;
+    }
+    auto offset = header.head;
+    auto count = std::uint64_t{};
+    while (count < header.count) {
+        std::memcpy(&size, _base + offset, sizeof(size));
+        if (size == 0 && offset != DATA_START) {
+            offset = DATA_START;
+            continue;
+        }
+        if (_capacity - offset < sizeof(record_header_t)) {
+            break;
+        }
+        auto record = record_header_t{};
+        std::memcpy(&record, _base + offset, sizeof(record));
+        if (record.size % RECORD_ALIGN != 0 || record.size > _capacity - offset ||
+            record_size(record.key_len, record.encoding_len, record.value_len) != record.size ||
+            crc32(
+                _base + offset + RECORD_CRC_OFFSET,
+                sizeof(record) - RECORD_CRC_OFFSET + record.key_len + record.encoding_len +
+                    record.value_len) != record.crc) {
+            break;
+        }
+        offset = (offset + record.size == _capacity) ? DATA_START : offset + record.size;
+        ++count;
+    }
+    header.count = count;
+    header.tail = (count == 0) ? header.head : offset;
+}
+
+auto outbox_t::append(
+    std::string_view key,
+    std::string_view value,
+    std::string_view encoding,
+    std::uint64_t timestamp) //
+    -> int
+{
+    const auto size = record_size(key.size(), encoding.size(), value.size());
+    {
+        auto lock = std::lock_guard{_mutex};
+
+        if (!_base || key.size() > std::numeric_limits<std::uint16_t>::max() ||
+            encoding.size() > std::numeric_limits<std::uint16_t>::max() ||
+            size > _capacity - DATA_START) {
+            ++_discarded;
+            return -1;
+        }
+
+        auto& header = header_of(_base);
+        /* make room, oldest first */
+        while (header.count > 0) {
+            if (header.tail > header.head &&
+                (_capacity - header.tail >= size || header.head - DATA_START >= size)) {
+                break;
+            }
+            if (header.tail < header.head && header.head - header.tail >= size) {
+                break;
+            }
+            drop_oldest();
+            ++_discarded;
+        }
+        if (header.count == 0) {
+            header.head = DATA_START;
+            header.tail = DATA_START;
+        }
+        if (_capacity - header.tail < size) {
+            std::memset(_base + header.tail, 0, sizeof(std::uint32_t));
+            header.tail = DATA_START;
+        }
+
+        auto record = record_header_t{
+            static_cast<std::uint32_t>(size),
+            0,
+            timestamp,
+            static_cast<std::uint16_t>(key.size()),
+            static_cast<std::uint16_t>(encoding.size()),
+            static_cast<std::uint32_t>(value.size())};
+
+        auto pos = _base + header.tail;
+        std::memcpy(pos + sizeof(record), key.data(), key.size());
+        std::memcpy(pos + sizeof(record) + key.size(), encoding.data(), encoding.size());
+        std::memcpy(
+            pos + sizeof(record) + key.size() + encoding.size(),
+            value.data(),
+            value.size());
+        std::memcpy(pos, &record, sizeof(record));
+        record.crc = crc32(
+            pos + RECORD_CRC_OFFSET,
+            sizeof(record) - RECORD_CRC_OFFSET + key.size() + encoding.size() + value.size());
+        std::memcpy(pos + offsetof(record_header_t, crc), &record.crc, sizeof(record.crc));
+
+        /* the record becomes visible to recovery only once tail and count include it */
+        header.tail = (header.tail + size == _capacity) ? DATA_START : header.tail + size;
+        ++header.count;
+        _pending = header.count;
+        ++_buffered;
+    }
+    _cv.notify_one();
+
+    return 0;
+}
+
+auto outbox_t::is_buffering() const noexcept //
+    -> bool
+{
+    return !_online.load(std::memory_order_relaxed) || _pending.load(std::memory_order_relaxed);
+}
+
+auto outbox_t::start(publish_t publish, online_t online) //
+    -> void
+{
+    {
+        auto lock = std::lock_guard{_replay_mutex};
+        _online = online();
+        _publish = std::move(publish);
+        _is_online = std::move(online);
+    }
+    _cv.notify_all();
+}
+
+auto outbox_t::stop() //
+    -> void
+{
+    auto lock = std::lock_guard{_replay_mutex};
+    _online = false;
+    _publish = nullptr;
+    _is_online = nullptr;
+}
+
+auto outbox_t::stats() const //
+    -> outbox_stats_t
+{
+    return outbox_stats_t{
+        _buffered.load(),
+        _replayed.load(),
+        _discarded.load(),
+        _pending.load(),
+    };
+}
+
+auto outbox_t::front(record_t& record) const //
+    -> bool
+{
+    auto lock = std::lock_guard{_mutex};
+
+    const auto& header = header_of(_base);
+    if (header.count == 0) {
+        return false;
+    }
+
+    auto rec = record_header_t{};
+    std::memcpy(&rec, _base + header.head, sizeof(rec));
+    const auto data = _base + header.head + sizeof(rec);
+    record.seqno = _head_seqno;
+    record.key.assign(data, rec.key_len);
+    record.encoding.assign(data + rec.key_len, rec.encoding_len);
+    record.value.assign(data + rec.key_len + rec.encoding_len, rec.value_len);
+    record.timestamp = rec.timestamp;
+
+    return true;
+}
+
+auto outbox_t::pop(std::uint64_t seqno) //
+    -> void
+{
+    auto lock = std::lock_guard{_mutex};
+
+    /* the record may have been discarded to make room while it was published */
+    if (seqno == _head_seqno && header_of(_base).count > 0) {
+        drop_oldest();
+        _pending = header_of(_base).count;
+    }
+}
+
+auto outbox_t::drop_oldest() //
+    -> void
+{
+    auto& header = header_of(_base);
+
+    auto size = std::uint32_t{};
+    std::memcpy(&size, _base + header.head, sizeof(size));
+    header.head += size;
+    --header.count;
+    ++_head_seqno;
+
+    /* skip the space left at the end of the file by a record that started over */
+    if (header.head == _capacity) {
+        header.head = DATA_START;
+    } else if (header.count > 0) {
+        std::memcpy(&size, _base + header.head, sizeof(size));
+        if (size == 0) {
+            header.head = DATA_START;
+        }
+    }
+    if (header.count == 0) {
+        header.head = DATA_START;
+        header.tail = DATA_START;
+    }
+}
+
+auto outbox_t::replay() //
+    -> void
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto period = (_options.replay_rate == 0)
+                            ? clock::duration{}
+                            : clock::duration{std::chrono::seconds{1}} /
+                                  static_cast<clock::rep>(_options.replay_rate);
+
+    auto record = record_t{};
+    auto last_check = clock::time_point{};
+    auto next = clock::time_point{};
+
+    auto lock = std::unique_lock{_replay_mutex};
+    while (!_stop) {
+        const auto now = clock::now();
+        if (now - last_check >= CHECK_INTERVAL) {
+            last_check = now;
+            _online = _is_online && _is_online();
+            ::msync(_base, _capacity, MS_ASYNC);
+        }
+
+        if (!_online || !front(record)) {
+            _cv.wait_for(lock, CHECK_INTERVAL);
+            continue;
+        }
+        if (_publish(record.key, record.value, record.encoding, record.timestamp) != 0) {
+            _online = false;
+            continue;
+        }
+        pop(record.seqno);
+        ++_replayed;
+
+        /* throttle without catching up on time spent waiting for the router */
+        next = std::max(next, now) + period;
+        _cv.wait_until(lock, next, [this] { return _stop; });
+    }
+}
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,73 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/resume_thread.h"
+
+namespace flunder {
+namespace impl {
+
+resume_thread_t::resume_thread_t()
+    : _queue{std::make_shared<queue_t>()}
+    , _thread{}
+{}
+
+resume_thread_t::~resume_thread_t()
+{
+    {
+        auto lock = std::lock_guard{_queue->mutex};
+        _queue->stop = true;
+    }
+    _queue->cv.notify_all();
+    if (!_thread.joinable()) {
+        return;
+    }
+    /* a coroutine destroying the client runs on the thread, which then ends by itself */
+    if (std::this_thread::get_id() == _thread.get_id()) {
+        _thread.detach();
+    } else {
+        _thread.join();
+    }
+}
+
+auto resume_thread_t::post(std::coroutine_handle<> handle) //
+    -> void
+{
+    /* notified with the lock held, as the resumed coroutine may destroy this right away */
+    auto lock = std::lock_guard{_queue->mutex};
+    _queue->handles.push_back(handle);
+    if (!_thread.joinable()) {
+        _thread = std::thread{&resume_thread_t::run, _queue};
+    }
+    _queue->cv.notify_one();
+}
+
+auto resume_thread_t::run(std::shared_ptr<queue_t> queue) //
+    -> void
+{
+    auto lock = std::unique_lock{queue->mutex};
+    while (true) {
+        queue->cv.wait(lock, [&queue] { return queue->stop || !queue->handles.empty(); });
+        if (queue->handles.empty()) {
+            return;
+        }
+        const auto handle = queue->handles.front();
+        queue->handles.pop_front();
+        lock.unlock();
+        handle.resume();
+        lock.lock();
+    }
+}
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,551 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/segment_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+namespace flunder {
+namespace impl {
+
+namespace {
+
+//  segment file
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | magic "FLSG"                      | version                           |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | seqno                                                                 |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+// | record 0 ... record n | 0 ...                                         |
+//  -------- -------- -------- -------- -------- -------- -------- --------
+struct segment_header_t
+{
+    std::array<char, 4> magic;
+    std::uint32_t version;
+    std::uint64_t seqno;
+};
+
+constexpr auto SEGMENT_MAGIC = std::array<char, 4>{'F', 'L', 'S', 'G'};
+constexpr auto SEGMENT_VERSION = std::uint32_t{1};
+constexpr auto SEGMENT_SUFFIX = std::string_view{".seg"};
+
+constexpr auto crc32_table = [] {
+    auto table = std::array<std::uint32_t, 256>{};
+    for (auto i = std::uint32_t{}; i < table.size(); ++i) {
+        auto crc = i;
+        for (auto bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : (crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+
+auto now() //
+    -> std::uint64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/* makes a created or removed directory entry durable */
+auto sync_dir(const std::string& path) //
+    -> void
+{
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd != -1) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+auto crc32(const char* data, std::size_t len) //
+    -> std::uint32_t
+{
+    auto crc = std::uint32_t{0xffffffff};
+    for (auto i = std::size_t{}; i < len; ++i) {
+        crc = crc32_table[(crc ^ static_cast<std::uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+auto record_size(std::size_t key_len, std::size_t encoding_len, std::size_t value_len) //
+    -> std::size_t
+{
+    const auto size = sizeof(record_header_t) + key_len + encoding_len + value_len;
+    return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+}
+
+segment_store_t::segment_store_t(local_storage_options_t options)
+    : _options{std::move(options)}
+    , _segments{}
+    , _index{}
+    , _last_sync{}
+    , _mutex{}
+{}
+
+segment_store_t::~segment_store_t()
+{
+    for (auto& segment : _segments) {
+        sync_segment(segment);
+        ::munmap(segment.base, segment.capacity);
+        ::close(segment.fd);
+    }
+}
+
+auto segment_store_t::open() //
+    -> int
+{
+    auto lock = std::lock_guard{_mutex};
+
+    if (_options.segment_size < sizeof(segment_header_t) + record_size(0, 0, 0) ||
+        _options.segment_size > std::numeric_limits<std::uint32_t>::max()) {
+        return -1;
+    }
+
+    auto ec = std::error_code{};
+    std::filesystem::create_directories(_options.path, ec);
+    if (ec) {
+        return -1;
+    }
+
+    auto seqnos = std::vector<std::uint64_t>{};
+    for (const auto& entry : std::filesystem::directory_iterator{_options.path, ec}) {
+        const auto name = entry.path().filename().string();
+        if (!name.ends_with(SEGMENT_SUFFIX)) {
+            continue;
+        }
+        const auto stem_end = name.data() + name.size() - SEGMENT_SUFFIX.size();
+        auto seqno = std::uint64_t{};
+        const auto [ptr, err] = std::from_chars(name.data(), stem_end, seqno, 16);
+        if (err == std::errc{} && ptr == stem_end) {
+            seqnos.push_back(seqno);
+        }
+    }
+    if (ec) {
+        return -1;
+    }
+    std::sort(seqnos.begin(), seqnos.end());
+
+    for (const auto seqno : seqnos) {
+        /* a gap means a segment was lost; continue with the newest contiguous run */
+        if (!_segments.empty() && seqno != _segments.back().seqno + 1) {
+            for (auto& segment : _segments) {
+                ::munmap(segment.base, segment.capacity);
+                ::close(segment.fd);
+            }
+            _segments.clear();
+        }
+        if (map_segment(seqno, false) != 0) {
+            continue;
+        }
+    }
+
+    _index.clear();
+    for (auto& segment : _segments) {
+        recover(segment);
+    }
+
+    if (_segments.empty() && map_segment(1, true) != 0) {
+        return -1;
+    }
+    _last_sync = std::chrono::steady_clock::now();
+
+    return 0;
+}
+
+auto segment_store_t::append(
+    std::string_view key,
+    std::string_view value,
+    std::string_view encoding,
+    std::uint64_t timestamp) //
+    -> int
+{
+    auto lock = std::lock_guard{_mutex};
+
+    if (_segments.empty()) {
+        return -1;
+    }
+
+    const auto res = do_append(key, value, encoding, timestamp);
+    if (res != 0) {
+        return res;
+    }
+    enforce_retention();
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - _last_sync >= _options.sync_interval) {
+        for (auto& segment : _segments) {
+            sync_segment(segment);
+        }
+        _last_sync = now;
+    }
+
+    return 0;
+}
+
+auto segment_store_t::latest(const match_t& match, const visit_t& visit) //
+    -> void
+{
+    auto lock = std::lock_guard{_mutex};
+
+    auto timestamp = std::string{};
+    for (const auto& [key, refs] : _index) {
+        if (match(key)) {
+            visit(read(refs.back(), timestamp));
+        }
+    }
+}
+
+auto segment_store_t::range(
+    const match_t& match,
+    std::uint64_t start,
+    std::uint64_t end,
+    const visit_t& visit) //
+    -> void
+{
+    auto lock = std::lock_guard{_mutex};
+
+    const auto older = [](const record_ref_t& ref, std::uint64_t timestamp) {
+        return ref.timestamp < timestamp;
+    };
+
+    auto timestamp = std::string{};
+    for (const auto& [key, refs] : _index) {
+        if (!match(key)) {
+            continue;
+        }
+        for (auto it = std::lower_bound(refs.cbegin(), refs.cend(), start, older);
+             it != refs.cend() && it->timestamp <= end;
+             ++it) {
+            visit(read(*it, timestamp));
+        }
+    }
+}
+
+auto segment_store_t::sync() //
+    -> int
+{
+    auto lock = std::lock_guard{_mutex};
+
+    auto res = 0;
+    for (auto& segment : _segments) {
+        if (sync_segment(segment) != 0) {
+            res = -1;
+        }
+    }
+    _last_sync = std::chrono::steady_clock::now();
+    return res;
+}
+
+auto segment_store_t::size() const //
+    -> std::size_t
+{
+    auto size = std::size_t{};
+    for (const auto& segment : _segments) {
+        size += segment.capacity;
+    }
+    return size;
+}
+
+auto segment_store_t::map_segment(std::uint64_t seqno, bool create) //
+    -> int
+{
+    const auto path = path_of(seqno);
+    const auto flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0);
+    const auto fd = ::open(path.c_str(), flags, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+
+    auto capacity = _options.segment_size;
+    if (create) {
+        if (::ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+            ::close(fd);
+            ::unlink(path.c_str());
+            return -1;
+        }
+    } else {
+        struct stat st = {};
+        if (::fstat(fd, &st) != 0 ||
+            static_cast<std::size_t>(st.st_size) < sizeof(segment_header_t)) {
+            ::close(fd);
+            return -1;
+        }
+        capacity = static_cast<std::size_t>(st.st_size);
+    }
+
+    const auto base = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        return -1;
+    }
+
+    auto segment = segment_t{seqno, fd, static_cast<char*>(base), capacity, 0, 0, 0};
+    auto header = segment_header_t{};
+    if (create) {
+        header = segment_header_t{SEGMENT_MAGIC, SEGMENT_VERSION, seqno};
+        std::memcpy(segment.base, &header, sizeof(header));
+        ::msync(segment.base, sizeof(header), MS_SYNC);
+        sync_dir(_options.path);
+    } else {
+        std::memcpy(&header, segment.base, sizeof(header));
+        if (header.magic != SEGMENT_MAGIC || header.version != SEGMENT_VERSION ||
+            header.seqno != seqno) {
+            ::munmap(segment.base, capacity);
+            ::close(fd);
+            return -1;
+        }
+    }
+    segment.end = sizeof(header);
+    segment.synced = sizeof(header);
+
+    _segments.push_back(segment);
+    return 0;
+}
+
+auto segment_store_t::recover(segment_t& segment) //
+    -> void
+{
+    auto offset = sizeof(segment_header_t);
+    auto corrupt = false;
+    while (offset + sizeof(record_header_t) <= segment.capacity) {
+        auto header = record_header_t{};
+        std::memcpy(&header, segment.base + offset, sizeof(header));
+        if (header.size == 0) {
+            break;
+        }
+        if (header.size % RECORD_ALIGN != 0 || offset + header.size > segment.capacity ||
+            record_size(header.key_len, header.encoding_len, header.value_len) != header.size ||
+            crc32(
+                segment.base + offset + RECORD_CRC_OFFSET,
+                sizeof(header) - RECORD_CRC_OFFSET + header.key_len + header.encoding_len +
+                    header.value_len) != header.crc) {
+            corrupt = true;
+            break;
+        }
+
+        index(
+            std::string_view{segment.base + offset + sizeof(header), header.key_len},
+            record_ref_t{segment.seqno, static_cast<std::uint32_t>(offset), header.timestamp});
+        segment.last_timestamp = std::max(segment.last_timestamp, header.timestamp);
+        offset += header.size;
+    }
+
+    /* discard the remains of a torn record, so later appends are not followed by garbage */
+    if (corrupt) {
+        std::memset(segment.base + offset, 0, segment.capacity - offset);
+        ::msync(segment.base, segment.capacity, MS_SYNC);
+    }
+    segment.end = offset;
+    segment.synced = offset;
+}
+
+auto segment_store_t::do_append(
+    std::string_view key,
+    std::string_view value,
+    std::string_view encoding,
+    std::uint64_t timestamp) //
+    -> int
+{
+    if (key.size() > std::numeric_limits<std::uint16_t>::max() ||
+        encoding.size() > std::numeric_limits<std::uint16_t>::max()) {
+        return -1;
+    }
+    const auto size = record_size(key.size(), encoding.size(), value.size());
+    if (size > _options.segment_size - sizeof(segment_header_t)) {
+        return -1;
+    }
+
+    if (_segments.back().end + size > _segments.back().capacity && roll() != 0) {
+        return -1;
+    }
+    auto& segment = _segments.back();
+
+    auto header = record_header_t{
+        static_cast<std::uint32_t>(size),
+        0,
+        timestamp,
+        static_cast<std::uint16_t>(key.size()),
+        static_cast<std::uint16_t>(encoding.size()),
+        static_cast<std::uint32_t>(value.size())};
+
+    auto pos = segment.base + segment.end;
+    std::memcpy(pos + sizeof(header), key.data(), key.size());
+    std::memcpy(pos + sizeof(header) + key.size(), encoding.data(), encoding.size());
+    std::memcpy(pos + sizeof(header) + key.size() + encoding.size(), value.data(), value.size());
+    std::memcpy(pos, &header, sizeof(header));
+    header.crc = crc32(
+        pos + RECORD_CRC_OFFSET,
+        sizeof(header) - RECORD_CRC_OFFSET + key.size() + encoding.size() + value.size());
+    std::memcpy(pos + offsetof(record_header_t, crc), &header.crc, sizeof(header.crc));
+
+    index(key, record_ref_t{segment.seqno, static_cast<std::uint32_t>(segment.end), timestamp});
+    segment.last_timestamp = std::max(segment.last_timestamp, timestamp);
+    segment.end += size;
+
+    return 0;
+}
+
+auto segment_store_t::roll() //
+    -> int
+{
+    sync_segment(_segments.back());
+    return map_segment(_segments.back().seqno + 1, true);
+}
+
+auto segment_store_t::enforce_retention() //
+    -> void
+{
+    if (_options.max_age.count() > 0) {
+        const auto max_age = std::chrono::duration_cast<std::chrono::nanoseconds>(_options.max_age);
+        const auto cutoff = now() - static_cast<std::uint64_t>(max_age.count());
+        while (_segments.size() > 1 && _segments.front().last_timestamp < cutoff) {
+            drop_oldest(false);
+        }
+    }
+
+    if (_options.max_size > 0) {
+        /* bounded, as carrying records forward may roll over into new segments */
+        for (auto n = _segments.size(); n > 1 && size() > _options.max_size; --n) {
+            drop_oldest(true);
+        }
+    }
+}
+
+auto segment_store_t::drop_oldest(bool carry_forward) //
+    -> void
+{
+    const auto segment = _segments.front();
+
+    if (carry_forward) {
+        auto live = std::vector<std::pair<std::string, record_ref_t>>{};
+        for (const auto& [key, refs] : _index) {
+            if (refs.back().seqno == segment.seqno) {
+                live.emplace_back(key, refs.back());
+            }
+        }
+        auto timestamp = std::string{};
+        for (const auto& [key, ref] : live) {
+            const auto var = read(ref, timestamp);
+            do_append(var.topic(), var.value(), var.encoding(), ref.timestamp);
+        }
+    }
+
+    for (auto it = _index.begin(); it != _index.end();) {
+        std::erase_if(it->second, [&segment](const record_ref_t& ref) {
+            return ref.seqno == segment.seqno;
+        });
+        it = it->second.empty() ? _index.erase(it) : std::next(it);
+    }
+
+    ::munmap(segment.base, segment.capacity);
+    ::close(segment.fd);
+    ::unlink(path_of(segment.seqno).c_str());
+    sync_dir(_options.path);
+    _segments.pop_front();
+}
+
+auto segment_store_t::sync_segment(segment_t& segment) //
+    -> int
+{
+    if (segment.synced == segment.end) {
+        return 0;
+    }
+    static const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const auto begin = segment.synced & ~(page_size - 1);
+    if (::msync(segment.base + begin, segment.end - begin, MS_SYNC) != 0) {
+        return -1;
+    }
+    segment.synced = segment.end;
+    return 0;
+}
+
+auto segment_store_t::index(std::string_view key, record_ref_t ref) //
+    -> void
+{
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        it = _index.emplace(std::string{key}, std::vector<record_ref_t>{}).first;
+    }
+
+    auto& refs = it->second;
+    if (refs.empty() || refs.back().timestamp <= ref.timestamp) {
+        refs.push_back(ref);
+    } else {
+        refs.insert(
+            std::upper_bound(
+                refs.begin(),
+                refs.end(),
+                ref.timestamp,
+                [](std::uint64_t timestamp, const record_ref_t& ref) {
+                    return timestamp < ref.timestamp;
+                }),
+            ref);
+    }
+}
+
+auto segment_store_t::read(const record_ref_t& ref, std::string& timestamp) const //
+    -> variable_t
+{
+    const auto& segment = _segments[ref.seqno - _segments.front().seqno];
+    const auto pos = segment.base + ref.offset;
+
+    auto header = record_header_t{};
+    std::memcpy(&header, pos, sizeof(header));
+
+    timestamp.resize(std::numeric_limits<std::uint64_t>::digits10 + 1);
+    const auto [end, ec] =
+        std::to_chars(timestamp.data(), timestamp.data() + timestamp.size(), header.timestamp);
+    timestamp.resize(end - timestamp.data());
+
+    const auto key = pos + sizeof(header);
+    const auto encoding = key + header.key_len;
+    const auto value = encoding + header.encoding_len;
+    return variable_t{
+        std::string_view{key, header.key_len},
+        std::string_view{value, header.value_len},
+        std::string_view{encoding, header.encoding_len},
+        std::string_view{timestamp}};
+}
+
+auto segment_store_t::path_of(std::uint64_t seqno) const //
+    -> std::string
+{
+    auto name = std::array<char, 16>{};
+    const auto [end, ec] = std::to_chars(name.data(), name.data() + name.size(), seqno, 16);
+    auto path = _options.path;
+    path.append("/")
+        .append(name.size() - (end - name.data()), '0')
+        .append(name.data(), end)
+        .append(SEGMENT_SUFFIX);
+    return path;
+}
+
+} // namespace impl
+} // namespace flunder
@@ -0,0 +1,392 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/series.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+
+namespace flunder {
+namespace impl {
+
+namespace {
+
+constexpr auto mask(unsigned count) //
+    -> std::uint64_t
+{
+    return (count >= 64) ? ~std::uint64_t{} : (std::uint64_t{1} << count) - 1;
+}
+
+constexpr auto sign_extend(std::uint64_t bits, unsigned count) //
+    -> std::int64_t
+{
+    const auto shift = 64 - count;
+    return static_cast<std::int64_t>(bits << shift) >> shift;
+}
+
+constexpr auto fits(std::int64_t value, unsigned count) //
+    -> bool
+{
+    const auto min = -(std::int64_t{1} << (count - 1));
+    const auto max = (std::int64_t{1} << (count - 1)) - 1;
+    return value >= min && value <= max;
+}
+
+/* delta-of-delta buckets: a control prefix of n one bits followed by a zero (omitted for the
+ * last bucket) selects the width of the value that follows; a single zero bit encodes 0 */
+constexpr auto DOD_WIDTHS = std::array<unsigned, 5>{7, 14, 24, 32, 64};
+
+/* blocks are also cut at multiples of this window since the epoch, as in Gorilla, so no block
+ * straddles a bucket whose width is a multiple of it and downsampling merges block summaries */
+constexpr auto BLOCK_WINDOW = std::int64_t{15} * 60 * 1'000'000'000;
+
+constexpr auto window_of(std::int64_t timestamp) //
+    -> std::int64_t
+{
+    return timestamp / BLOCK_WINDOW - (timestamp % BLOCK_WINDOW < 0);
+}
+
+/* marks a block that has not yet encoded a meaningful XOR window */
+constexpr auto NO_WINDOW = unsigned{64};
+
+} // namespace
+
+bit_writer_t::bit_writer_t()
+    : _words{}
+    , _size{}
+{}
+
+auto bit_writer_t::write(std::uint64_t bits, unsigned count) //
+    -> void
+{
+    if (count == 0) {
+        return;
+    }
+    bits &= mask(count);
+
+    const auto offset = static_cast<unsigned>(_size % 64);
+    if (offset == 0) {
+        _words.push_back(0);
+    }
+    const auto free = 64 - offset;
+    if (count <= free) {
+        _words.back() |= bits << (free - count);
+    } else {
+        const auto rest = count - free;
+        _words.back() |= bits >> rest;
+        _words.push_back(bits << (64 - rest));
+    }
+    _size += count;
+}
+
+auto bit_writer_t::words() const noexcept //
+    -> const std::vector<std::uint64_t>&
+{
+    return _words;
+}
+
+auto bit_writer_t::size() const noexcept //
+    -> std::size_t
+{
+    return _size;
+}
+
+auto bit_writer_t::shrink_to_fit() //
+    -> void
+{
+    _words.shrink_to_fit();
+}
+
+bit_reader_t::bit_reader_t(const std::vector<std::uint64_t>& words)
+    : _words{words.data()}
+    , _pos{}
+{}
+
+auto bit_reader_t::read(unsigned count) //
+    -> std::uint64_t
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    const auto word = _pos / 64;
+    const auto free = 64 - static_cast<unsigned>(_pos % 64);
+    _pos += count;
+    if (count <= free) {
+        return (_words[word] >> (free - count)) & mask(count);
+    }
+    const auto rest = count - free;
+    return ((_words[word] & mask(free)) << rest) | (_words[word + 1] >> (64 - rest));
+}
+
+auto bit_reader_t::read_bit() //
+    -> bool
+{
+    const auto bit = (_words[_pos / 64] >> (63 - _pos % 64)) & 1;
+    ++_pos;
+    return bit != 0;
+}
+
+series_t::series_t(std::size_t block_size)
+    : _block_size{std::max<std::size_t>(block_size, 2)}
+    , _blocks{}
+    , _size{}
+{}
+
+auto series_t::append(sample_t sample) //
+    -> int
+{
+    if (!_blocks.empty() && sample.timestamp < _blocks.back().last_timestamp) {
+        return -1;
+    }
+
+    const auto value = std::bit_cast<std::uint64_t>(sample.value);
+    if (_blocks.empty() || _blocks.back().count == _block_size ||
+        window_of(sample.timestamp) != window_of(_blocks.back().first_timestamp)) {
+        if (!_blocks.empty()) {
+            _blocks.back().bits.shrink_to_fit();
+        }
+        auto& block = _blocks.emplace_back();
+        block.bits.write(static_cast<std::uint64_t>(sample.timestamp), 64);
+        block.bits.write(value, 64);
+        block.count = 1;
+        block.first_timestamp = sample.timestamp;
+        block.last_timestamp = sample.timestamp;
+        block.last_delta = 0;
+        block.last_value = value;
+        block.leading = NO_WINDOW;
+        block.trailing = 0;
+        block.summary = bucket_t{
+            sample.timestamp,
+            1,
+            sample.value,
+            sample.value,
+            sample.value,
+            sample.value,
+            sample.value};
+    } else {
+        auto& block = _blocks.back();
+        encode_timestamp(block, sample.timestamp);
+        encode_value(block, value);
+        ++block.count;
+        block.summary.count = block.count;
+        block.summary.min = std::min(block.summary.min, sample.value);
+        block.summary.max = std::max(block.summary.max, sample.value);
+        block.summary.sum += sample.value;
+        block.summary.last = sample.value;
+    }
+    ++_size;
+
+    return 0;
+}
+
+auto series_t::encode_timestamp(block_t& block, std::int64_t timestamp) //
+    -> void
+{
+    const auto delta = timestamp - block.last_timestamp;
+    const auto dod = delta - block.last_delta;
+    block.last_delta = delta;
+    block.last_timestamp = timestamp;
+
+    if (dod == 0) {
+        block.bits.write(0b0, 1);
+        return;
+    }
+    for (auto i = std::size_t{}; i < DOD_WIDTHS.size(); ++i) {
+        if (i == DOD_WIDTHS.size() - 1 || fits(dod, DOD_WIDTHS[i])) {
+            /* i + 1 one bits, terminated by a zero unless this is the last bucket */
+            const auto prefix_len = static_cast<unsigned>(i + 1 + (i < DOD_WIDTHS.size() - 1));
+            const auto prefix = mask(i + 1) << (prefix_len - (i + 1));
+            block.bits.write(prefix, prefix_len);
+            block.bits.write(static_cast<std::uint64_t>(dod), DOD_WIDTHS[i]);
+            return;
+        }
+    }
+}
+
+auto series_t::encode_value(block_t& block, std::uint64_t value) //
+    -> void
+{
+    const auto xored = value ^ block.last_value;
+    block.last_value = value;
+
+    if (xored == 0) {
+        block.bits.write(0b0, 1);
+        return;
+    }
+
+    /* leading zeros are stored in 5 bits */
+    const auto leading = std::min(static_cast<unsigned>(std::countl_zero(xored)), 31u);
+    const auto trailing = static_cast<unsigned>(std::countr_zero(xored));
+
+    if (block.leading != NO_WINDOW && leading >= block.leading && trailing >= block.trailing) {
+        block.bits.write(0b10, 2);
+        block.bits.write(xored >> block.trailing, 64 - block.leading - block.trailing);
+        return;
+    }
+
+    /* meaningful bits are stored in 6 bits, where 0 stands for 64 */
+    const auto meaningful = 64 - leading - trailing;
+    block.bits.write(0b11, 2);
+    block.bits.write(leading, 5);
+    block.bits.write(meaningful, 6);
+    block.bits.write(xored >> trailing, meaningful);
+    block.leading = leading;
+    block.trailing = trailing;
+}
+
+auto series_t::decode(const block_t& block, std::vector<sample_t>& samples) const //
+    -> void
+{
+    samples.clear();
+    if (block.count == 0) {
+        return;
+    }
+
+    auto reader = bit_reader_t{block.bits.words()};
+    auto timestamp = static_cast<std::int64_t>(reader.read(64));
+    auto value = reader.read(64);
+    samples.push_back(sample_t{timestamp, std::bit_cast<double>(value)});
+
+    auto delta = std::int64_t{};
+    auto leading = unsigned{};
+    auto trailing = unsigned{};
+    for (auto i = std::size_t{1}; i < block.count; ++i) {
+        auto bucket = std::size_t{};
+        while (bucket < DOD_WIDTHS.size() && reader.read_bit()) {
+            ++bucket;
+        }
+        if (bucket > 0) {
+            const auto width = DOD_WIDTHS[bucket - 1];
+            delta += sign_extend(reader.read(width), width);
+        }
+        timestamp += delta;
+
+        if (reader.read_bit()) {
+            if (reader.read_bit()) {
+                leading = static_cast<unsigned>(reader.read(5));
+                const auto meaningful = static_cast<unsigned>(reader.read(6));
+                trailing = 64 - leading - (meaningful == 0 ? 64 : meaningful);
+            }
+            value ^= reader.read(64 - leading - trailing) << trailing;
+        }
+        samples.push_back(sample_t{timestamp, std::bit_cast<double>(value)});
+    }
+}
+
+auto series_t::expire(std::int64_t timestamp) //
+    -> void
+{
+    while (!_blocks.empty() && _blocks.front().last_timestamp < timestamp) {
+        _size -= _blocks.front().count;
+        _blocks.pop_front();
+    }
+}
+
+auto series_t::scan(std::int64_t start, std::int64_t end, const history_t::scan_cbk_t& cbk) const //
+    -> void
+{
+    const auto older = [](const sample_t& sample, std::int64_t timestamp) {
+        return sample.timestamp < timestamp;
+    };
+    const auto newer = [](std::int64_t timestamp, const sample_t& sample) {
+        return timestamp < sample.timestamp;
+    };
+
+    auto samples = std::vector<sample_t>{};
+    samples.reserve(_block_size);
+    for (const auto& block : _blocks) {
+        if (block.last_timestamp < start) {
+            continue;
+        }
+        if (block.first_timestamp > end) {
+            break;
+        }
+        decode(block, samples);
+        const auto first = std::lower_bound(samples.cbegin(), samples.cend(), start, older);
+        const auto last = std::upper_bound(first, samples.cend(), end, newer);
+        if (first != last) {
+            cbk(std::span<const sample_t>{first, last});
+        }
+    }
+}
+
+auto series_t::aggregate(std::int64_t start, std::int64_t end, aggregator_t& aggregator) const //
+    -> void
+{
+    auto samples = std::vector<sample_t>{};
+    for (const auto& block : _blocks) {
+        if (block.last_timestamp < start) {
+            continue;
+        }
+        if (block.first_timestamp > end) {
+            break;
+        }
+        const auto bucket = aggregator.bucket_start(block.first_timestamp);
+        if (block.first_timestamp >= start && block.last_timestamp <= end &&
+            bucket == aggregator.bucket_start(block.last_timestamp)) {
+            auto partial = block.summary;
+            partial.start = bucket;
+            aggregator.push(partial);
+            continue;
+        }
+        if (samples.capacity() == 0) {
+            samples.reserve(_block_size);
+        }
+        decode(block, samples);
+        const auto first = std::lower_bound(
+            samples.cbegin(),
+            samples.cend(),
+            start,
+            [](const sample_t& sample, std::int64_t timestamp) {
+                return sample.timestamp < timestamp;
+            });
+        const auto last = std::upper_bound(
+            first,
+            samples.cend(),
+            end,
+            [](std::int64_t timestamp, const sample_t& sample) {
+                return timestamp < sample.timestamp;
+            });
+        aggregator.push(std::span<const sample_t>{first, last});
+    }
+}
+
+auto series_t::size() const noexcept //
+    -> std::size_t
+{
+    return _size;
+}
+
+auto series_t::memory_usage() const noexcept //
+    -> std::size_t
+{
+    auto bytes = sizeof(*this);
+    for (const auto& block : _blocks) {
+        bytes += sizeof(block) + block.bits.words().capacity() * sizeof(std::uint64_t);
+    }
+    return bytes;
+}
+
+auto series_t::newest() const noexcept //
+    -> std::int64_t
+{
+    return _blocks.empty() ? std::numeric_limits<std::int64_t>::min()
+                           : _blocks.back().last_timestamp;
+}
+
+} // namespace impl
+} // namespace flunder
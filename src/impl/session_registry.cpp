@@ -0,0 +1,232 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/impl/session_registry.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace flunder {
+namespace impl {
+
+auto connected_router_count(const z_owned_session_t& session) //
+    -> int
+{
+    int routers = 0;
+    auto lambda = [](const struct z_id_t*, void* counter) { *static_cast<int*>(counter) += 1; };
+
+    auto callback = z_owned_closure_zid_t{};
+    z_closure(&callback, lambda, nullptr, &routers);
+    if (z_info_routers_zid(
+            z_session_loan(&session),
+            reinterpret_cast<z_moved_closure_zid_t*>(&callback)) != 0) {
+        return 0;
+    }
+    return routers;
+}
+
+auto connected_peer_count(const z_owned_session_t& session) //
+    -> int
+{
+    int peers = 0;
+    auto lambda = [](const struct z_id_t*, void* counter) { *static_cast<int*>(counter) += 1; };
+
+    auto callback = z_owned_closure_zid_t{};
+    z_closure(&callback, lambda, nullptr, &peers);
+    if (z_info_peers_zid(
+            z_session_loan(&session),
+            reinterpret_cast<z_moved_closure_zid_t*>(&callback)) != 0) {
+        return 0;
+    }
+    return peers;
+}
+
+session_monitor_t::session_monitor_t(
+    const z_owned_session_t* session, bool peer, std::chrono::milliseconds interval)
+    : _session{session}
+    , _peer{peer}
+    , _interval{interval}
+    , _watchers{}
+    , _current{}
+    , _online{true}
+    , _stop{}
+    , _mutex{}
+    , _cv{}
+    , _thread{}
+{}
+
+session_monitor_t::~session_monitor_t()
+{
+    stop();
+}
+
+auto session_monitor_t::stop() //
+    -> void
+{
+    {
+        auto lock = std::lock_guard{_mutex};
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+auto session_monitor_t::watch(const void* watcher, watch_cbk_t cbk) //
+    -> void
+{
+    auto lock = std::lock_guard{_mutex};
+    if (!_online) {
+        cbk(false);
+    }
+    _watchers[watcher] = std::make_shared<watch_cbk_t>(std::move(cbk));
+    if (!_stop && !_thread.joinable()) {
+        _thread = std::thread{&session_monitor_t::run, this};
+    }
+}
+
+auto session_monitor_t::unwatch(const void* watcher) //
+    -> void
+{
+    auto lock = std::unique_lock{_mutex};
+    _watchers.erase(watcher);
+    if (std::this_thread::get_id() == _thread.get_id()) {
+        return;
+    }
+    _cv.wait(lock, [this, watcher] { return _current != watcher; });
+}
+
+auto session_monitor_t::is_online() const //
+    -> bool
+{
+    if (connected_router_count(*_session) > 0) {
+        return true;
+    }
+    return _peer && connected_peer_count(*_session) > 0;
+}
+
+auto session_monitor_t::run() //
+    -> void
+{
+    /* zenoh reconnects the session to any of the endpoints by itself, re-declaring subscribers
+     * and queryables; state held by the router has to be restored by the watchers */
+    auto lock = std::unique_lock{_mutex};
+    while (!_cv.wait_for(lock, _interval, [this] { return _stop; })) {
+        lock.unlock();
+        const auto online = is_online();
+        lock.lock();
+        if (_stop || online == _online) {
+            continue;
+        }
+        _online = online;
+
+        /* watchers may block or unwatch, so they are invoked without _mutex held */
+        using entry_t = std::pair<const void*, std::shared_ptr<watch_cbk_t>>;
+        const auto watchers = std::vector<entry_t>{_watchers.cbegin(), _watchers.cend()};
+        for (const auto& [watcher, cbk] : watchers) {
+            const auto it = _watchers.find(watcher);
+            if (it == _watchers.end() || it->second != cbk) {
+                continue;
+            }
+            _current = watcher;
+            lock.unlock();
+            (*cbk)(online);
+            lock.lock();
+            _current = nullptr;
+            _cv.notify_all();
+        }
+    }
+}
+
+/* closes the session; a monitor, if any, is stopped before */
+struct session_deleter_t
+{
+    auto operator()(z_owned_session_t* session) const //
+        -> void
+    {
+        if (monitor) {
+            monitor->stop();
+        }
+        auto opt = z_close_options_t{};
+        z_close_options_default(&opt);
+        z_close(z_loan_mut(*session), &opt);
+        z_drop(z_move(*session));
+        delete session;
+    }
+
+    std::shared_ptr<session_monitor_t> monitor;
+};
+
+auto make_session(z_owned_session_t session) //
+    -> session_ptr_t
+{
+    return session_ptr_t{new z_owned_session_t{session}, session_deleter_t{}};
+}
+
+auto make_session(z_owned_session_t session, bool peer, std::chrono::milliseconds interval) //
+    -> session_ptr_t
+{
+    auto* owned = new z_owned_session_t{session};
+    return session_ptr_t{
+        owned,
+        session_deleter_t{std::make_shared<session_monitor_t>(owned, peer, interval)}};
+}
+
+auto session_monitor(const session_ptr_t& session) //
+    -> session_monitor_t*
+{
+    const auto* deleter = std::get_deleter<session_deleter_t>(session);
+    return deleter ? deleter->monitor.get() : nullptr;
+}
+
+auto session_registry_t::instance() //
+    -> session_registry_t&
+{
+    static auto registry = session_registry_t{};
+    return registry;
+}
+
+auto session_registry_t::acquire(const std::string& key, const open_t& open) //
+    -> session_ptr_t
+{
+    /* opening is serialized, so concurrent clients end up with the same session */
+    auto lock = std::lock_guard{_mutex};
+    if (auto session = _sessions[key].lock()) {
+        return session;
+    }
+
+    auto ptr = open();
+    if (!ptr) {
+        _sessions.erase(key);
+        return nullptr;
+    }
+    _sessions[key] = ptr;
+    std::erase_if(_sessions, [](const auto& entry) { return entry.second.expired(); });
+
+    return ptr;
+}
+
+auto session_registry_t::size() const //
+    -> std::size_t
+{
+    auto lock = std::lock_guard{_mutex};
+    return std::count_if(_sessions.cbegin(), _sessions.cend(), [](const auto& entry) {
+        return !entry.second.expired();
+    });
+}
+
+} // namespace impl
+} // namespace flunder
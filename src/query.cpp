@@ -0,0 +1,204 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/query.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+
+namespace flunder {
+
+/* RFC 3339 UTC representation with nanosecond precision, as accepted in zenoh time ranges */
+static auto to_rfc3339(query_t::clock_t::time_point time) //
+    -> std::string
+{
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+    const auto secs = std::chrono::floor<std::chrono::seconds>(ns);
+    const auto t = static_cast<std::time_t>(secs.count());
+
+    auto tm = std::tm{};
+    gmtime_r(&t, &tm);
+
+    char buf[40];
+    std::snprintf(
+        buf,
+        sizeof(buf),
+        "%04d-%02d-%02dT%02d:%02d:%02d.%09lldZ",
+        tm.tm_year + 1900,
+        tm.tm_mon + 1,
+        tm.tm_mday,
+        tm.tm_hour,
+        tm.tm_min,
+        tm.tm_sec,
+        static_cast<long long>((ns - secs).count()));
+    return buf;
+}
+
+query_t::query_t(std::string_view topic)
+    : _topic{topic.starts_with('/') ? topic.substr(1) : topic}
+    , _params{}
+    , _limit{}
+    , _ordered{}
+    , _keys_only{}
+    , _target{query_target_t::all}
+    , _consolidation{consolidation_t::automatic}
+    , _timeout{}
+{}
+
+auto query_t::time_range(clock_t::time_point start, clock_t::time_point end) //
+    -> query_t&
+{
+    return time_range("[" + to_rfc3339(start) + ".." + to_rfc3339(end) + "]");
+}
+
+auto query_t::since(clock_t::duration duration) //
+    -> query_t&
+{
+    const auto seconds = std::chrono::duration<double>{duration}.count();
+
+    char buf[32];
+    const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), seconds);
+    return time_range("[now(-" + std::string{buf, end} + "s)..]");
+}
+
+auto query_t::time_range(std::string_view expr) //
+    -> query_t&
+{
+    return param("_time", expr);
+}
+
+auto query_t::limit(std::size_t n) //
+    -> query_t&
+{
+    _limit = n;
+    return *this;
+}
+
+auto query_t::ordered(bool ordered) //
+    -> query_t&
+{
+    _ordered = ordered;
+    return *this;
+}
+
+auto query_t::keys_only(bool keys_only) //
+    -> query_t&
+{
+    _keys_only = keys_only;
+    return *this;
+}
+
+auto query_t::target(query_target_t target) //
+    -> query_t&
+{
+    _target = target;
+    return *this;
+}
+
+auto query_t::consolidation(consolidation_t consolidation) //
+    -> query_t&
+{
+    _consolidation = consolidation;
+    return *this;
+}
+
+auto query_t::timeout(std::chrono::milliseconds timeout) //
+    -> query_t&
+{
+    _timeout = timeout;
+    return *this;
+}
+
+auto query_t::param(std::string_view key, std::string_view value) //
+    -> query_t&
+{
+    const auto it = std::find_if(_params.begin(), _params.end(), [key](const auto& param) {
+        return param.first == key;
+    });
+    if (it != _params.end()) {
+        it->second = value;
+    } else {
+        _params.emplace_back(key, value);
+    }
+    return *this;
+}
+
+auto query_t::topic() const noexcept //
+    -> std::string_view
+{
+    return _topic;
+}
+
+auto query_t::parameters() const //
+    -> std::string
+{
+    auto res = std::string{};
+    for (const auto& [key, value] : _params) {
+        /* keys_only() sets the parameter below, which would otherwise appear twice */
+        if (_keys_only && key == FLUNDER_KEYS_ONLY_PARAM) {
+            continue;
+        }
+        if (!res.empty()) {
+            res += ';';
+        }
+        res.append(key).append("=").append(value);
+    }
+    if (_keys_only) {
+        if (!res.empty()) {
+            res += ';';
+        }
+        res.append(FLUNDER_KEYS_ONLY_PARAM).append("=true");
+    }
+    return res;
+}
+
+auto query_t::limit() const noexcept //
+    -> std::size_t
+{
+    return _limit;
+}
+
+auto query_t::is_ordered() const noexcept //
+    -> bool
+{
+    return _ordered;
+}
+
+auto query_t::is_keys_only() const noexcept //
+    -> bool
+{
+    return _keys_only;
+}
+
+auto query_t::target() const noexcept //
+    -> query_target_t
+{
+    return _target;
+}
+
+auto query_t::consolidation() const noexcept //
+    -> consolidation_t
+{
+    return _consolidation;
+}
+
+auto query_t::timeout() const noexcept //
+    -> std::chrono::milliseconds
+{
+    return _timeout;
+}
+
+} // namespace flunder
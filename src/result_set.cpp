@@ -0,0 +1,176 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/result_set.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "flunder/client.h"
+
+namespace flunder {
+
+/* first block of the arena; every further block doubles in size up to MAX_BLOCK_SIZE */
+constexpr auto MIN_BLOCK_SIZE = std::size_t{16 * 1024};
+constexpr auto MAX_BLOCK_SIZE = std::size_t{16 * 1024 * 1024};
+
+FLECS_EXPORT result_set_t::result_set_t()
+    : _vars{}
+    , _blocks{}
+    , _block_size{MIN_BLOCK_SIZE}
+    , _pos{}
+    , _left{}
+    , _allocated{}
+    , _owners{}
+{}
+
+FLECS_EXPORT result_set_t::result_set_t(result_set_t&& other) noexcept
+    : result_set_t{}
+{
+    swap(*this, other);
+}
+
+FLECS_EXPORT result_set_t& result_set_t::operator=(result_set_t&& other) noexcept
+{
+    swap(*this, other);
+    return *this;
+}
+
+FLECS_EXPORT result_set_t::~result_set_t()
+{}
+
+FLECS_EXPORT auto result_set_t::push_back(const variable_t& var) //
+    -> const variable_t&
+{
+    const auto topic = store(var.topic());
+    const auto value = store(var.value());
+    const auto encoding = store(var.encoding());
+    const auto timestamp = store(var.timestamp());
+    return _vars.emplace_back(topic, value, encoding, timestamp);
+}
+
+FLECS_EXPORT auto result_set_t::reserve(std::size_t count, std::size_t bytes) //
+    -> void
+{
+    _vars.reserve(count);
+    /* four terminators per variable */
+    const auto needed = bytes + 4 * count;
+    if (needed > _left) {
+        _pos = allocate(needed);
+        _left = needed;
+    }
+}
+
+FLECS_EXPORT auto result_set_t::clear() noexcept //
+    -> void
+{
+    _vars.clear();
+    _blocks.clear();
+    _block_size = MIN_BLOCK_SIZE;
+    _pos = nullptr;
+    _left = 0;
+    _allocated = 0;
+    _owners.clear();
+}
+
+FLECS_EXPORT auto result_set_t::memory_usage() const noexcept //
+    -> std::size_t
+{
+    return _vars.capacity() * sizeof(variable_t) + _allocated;
+}
+
+auto result_set_t::retain(owner_t owner) //
+    -> void
+{
+    _owners.push_back(std::move(owner));
+}
+
+auto result_set_t::push_back_borrowed(
+    std::string_view topic,
+    std::string_view value,
+    std::string_view encoding,
+    std::string_view timestamp) //
+    -> const variable_t&
+{
+    return _vars.emplace_back(topic, value, store(encoding), store(timestamp));
+}
+
+auto result_set_t::store(std::string_view str) //
+    -> std::string_view
+{
+    if (str.size() + 1 > _left) {
+        const auto size = std::max(str.size() + 1, _block_size);
+        _block_size = std::min(_block_size * 2, MAX_BLOCK_SIZE);
+        _pos = allocate(size);
+        _left = size;
+    }
+    auto* start = _pos;
+    _pos = std::copy(str.cbegin(), str.cend(), _pos);
+    *_pos++ = '\0';
+    _left -= str.size() + 1;
+    return {start, str.size()};
+}
+
+auto result_set_t::allocate(std::size_t size) //
+    -> char*
+{
+    _allocated += size;
+    return _blocks.emplace_back(new char[size]).get();
+}
+
+FLECS_EXPORT auto swap(result_set_t& lhs, result_set_t& rhs) noexcept //
+    -> void
+{
+    using std::swap;
+    swap(lhs._vars, rhs._vars);
+    swap(lhs._blocks, rhs._blocks);
+    swap(lhs._block_size, rhs._block_size);
+    swap(lhs._pos, rhs._pos);
+    swap(lhs._left, rhs._left);
+    swap(lhs._allocated, rhs._allocated);
+    swap(lhs._owners, rhs._owners);
+}
+
+} // namespace flunder
+
+extern "C" {
+
+FLECS_EXPORT int flunder_get_result_set(const void* flunder, const char* topic, void** results)
+{
+    auto [res, result_set] =
+        static_cast<const flunder::client_t*>(flunder)->get_result_set(flunder::query_t{topic});
+    *results = static_cast<void*>(new flunder::result_set_t{std::move(result_set)});
+    return res;
+}
+
+FLECS_EXPORT size_t flunder_result_set_size(const void* results)
+{
+    return static_cast<const flunder::result_set_t*>(results)->size();
+}
+
+FLECS_EXPORT const variable_t* flunder_result_set_at(const void* results, size_t i)
+{
+    const auto* result_set = static_cast<const flunder::result_set_t*>(results);
+    if (i >= result_set->size()) {
+        return nullptr;
+    }
+    return &(*result_set)[i];
+}
+
+FLECS_EXPORT void flunder_result_set_destroy(void* results)
+{
+    delete static_cast<flunder::result_set_t*>(results);
+}
+
+} // extern "C"
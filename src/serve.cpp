@@ -0,0 +1,200 @@
+// Copyright 2021-2023 FLECS Technologies GmbH
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flunder/serve.h"
+
+#include <zenoh.h>
+
+#include <charconv>
+#include <cstdint>
+
+#include "flunder/impl/client.h"
+#include "flunder/query.h"
+
+namespace flunder {
+
+/* replies are timestamped with unix_time if given, with the current time otherwise */
+static auto do_reply(
+    const z_loaned_query_t* query,
+    const z_owned_session_t* session,
+    std::string_view key,
+    z_owned_bytes_t payload,
+    std::string_view encoding,
+    std::uint64_t unix_time = 0) //
+    -> int
+{
+    auto keyexpr = z_view_keyexpr_t{};
+    if (z_view_keyexpr_from_substr(&keyexpr, key.data(), key.size()) != 0) {
+        z_drop(z_move(payload));
+        return -1;
+    }
+
+    auto enc = z_owned_encoding_t{};
+    z_encoding_from_substr(&enc, encoding.data(), encoding.size());
+
+    auto timestamp = z_timestamp_t{};
+    z_timestamp_new(&timestamp, z_loan(*session));
+    if (unix_time != 0) {
+        timestamp.time = impl::unix_time_to_ntp64(unix_time);
+    }
+
+    auto options = z_query_reply_options_t{};
+    z_query_reply_options_default(&options);
+    options.encoding = z_move(enc);
+    options.timestamp = &timestamp;
+
+    const auto res = z_query_reply(query, z_loan(keyexpr), z_move(payload), &options);
+
+    return (res == 0) ? 0 : -1;
+}
+
+reply_builder_t::reply_builder_t(const z_loaned_query_t* query, const z_owned_session_t* session)
+    : _query{query}
+    , _session{session}
+    , _key_expr{}
+    , _parameters{}
+{
+    auto keyexpr = z_view_string_t{};
+    z_keyexpr_as_view_string(z_query_keyexpr(_query), &keyexpr);
+    _key_expr = std::string_view{z_string_data(z_loan(keyexpr)), z_string_len(z_loan(keyexpr))};
+
+    auto parameters = z_view_string_t{};
+    z_query_parameters(_query, &parameters);
+    _parameters =
+        std::string_view{z_string_data(z_loan(parameters)), z_string_len(z_loan(parameters))};
+}
+
+auto reply_builder_t::key_expr() const noexcept //
+    -> std::string_view
+{
+    return _key_expr;
+}
+
+auto reply_builder_t::parameters() const noexcept //
+    -> std::string_view
+{
+    return _parameters;
+}
+
+auto reply_builder_t::is_keys_only() const noexcept //
+    -> bool
+{
+    /* a bare key counts as set, like other boolean selector parameters */
+    const auto key = std::string_view{FLUNDER_KEYS_ONLY_PARAM};
+    auto parameters = _parameters;
+    while (!parameters.empty()) {
+        const auto sep = parameters.find(';');
+        const auto param = parameters.substr(0, sep);
+        const auto eq = param.find('=');
+        if (param.substr(0, eq) == key) {
+            return eq == std::string_view::npos || param.substr(eq + 1) == "true";
+        }
+        parameters =
+            (sep == std::string_view::npos) ? std::string_view{} : parameters.substr(sep + 1);
+    }
+    return false;
+}
+
+auto reply_builder_t::reply(
+    std::string_view key, std::string_view value, std::string_view encoding) //
+    -> int
+{
+    auto payload = z_owned_bytes_t{};
+    if (is_keys_only()) {
+        z_bytes_empty(&payload);
+    } else {
+        z_bytes_copy_from_buf(
+            &payload,
+            reinterpret_cast<const uint8_t*>(value.data()),
+            value.size());
+    }
+    return do_reply(_query, _session, key, payload, encoding);
+}
+
+auto reply_builder_t::reply(
+    std::string_view key, std::string&& value, std::string_view encoding) //
+    -> int
+{
+    if (is_keys_only()) {
+        return reply(key, std::string_view{}, encoding);
+    }
+
+    auto buf = new std::string{std::move(value)};
+    auto payload = z_owned_bytes_t{};
+    z_bytes_from_buf(
+        &payload,
+        reinterpret_cast<uint8_t*>(buf->data()),
+        buf->size(),
+        [](void*, void* ctx) { delete static_cast<std::string*>(ctx); },
+        buf);
+    return do_reply(_query, _session, key, payload, encoding);
+}
+
+auto reply_builder_t::reply(
+    std::string_view key,
+    const void* data,
+    std::size_t len,
+    std::string_view encoding,
+    void (*release)(void* data, void* ctx),
+    void* ctx) //
+    -> int
+{
+    if (is_keys_only()) {
+        release(const_cast<void*>(data), ctx);
+        return reply(key, std::string_view{}, encoding);
+    }
+
+    auto payload = z_owned_bytes_t{};
+    z_bytes_from_buf(
+        &payload,
+        static_cast<uint8_t*>(const_cast<void*>(data)),
+        len,
+        release,
+        ctx);
+    return do_reply(_query, _session, key, payload, encoding);
+}
+
+auto reply_builder_t::reply(const variable_t& var) //
+    -> int
+{
+    const auto ts = var.timestamp();
+    auto unix_time = std::uint64_t{};
+    std::from_chars(ts.data(), ts.data() + ts.size(), unix_time);
+
+    auto payload = z_owned_bytes_t{};
+    if (is_keys_only()) {
+        z_bytes_empty(&payload);
+    } else {
+        z_bytes_copy_from_buf(
+            &payload,
+            reinterpret_cast<const uint8_t*>(var.value().data()),
+            var.value().size());
+    }
+    return do_reply(_query, _session, var.topic(), payload, var.encoding(), unix_time);
+}
+
+} // namespace flunder
+
+extern "C" {
+
+FLECS_EXPORT int flunder_reply(
+    void* reply, const char* key, const void* data, size_t len, const char* encoding)
+{
+    return static_cast<flunder::reply_builder_t*>(reply)->reply(
+        key,
+        std::string_view{static_cast<const char*>(data), len},
+        encoding);
+}
+
+} // extern "C"
@@ -14,103 +14,343 @@
 
 #include "flunder/variable.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
 #include <cstring>
-#include <memory>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace flunder {
 
-/** @todo */
-template <class... Ts>
-struct overload : Ts...
+namespace {
+
+/* topics, encodings and timestamps are never near 4 GiB, so their lengths are kept in 32 bits */
+auto short_len(std::string_view str) //
+    -> std::uint32_t
+{
+    if (str.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error{"flunder::variable_t: string too long"};
+    }
+    return static_cast<std::uint32_t>(str.size());
+}
+
+auto is_text_encoding(std::string_view encoding) noexcept //
+    -> bool
+{
+    return encoding.empty() || encoding.starts_with("text/plain");
+}
+
+auto is_binary_encoding(std::string_view encoding) noexcept //
+    -> bool
+{
+    return encoding == "application/octet-stream" || encoding == "zenoh/bytes";
+}
+
+template <typename T>
+auto parse(std::string_view str) noexcept //
+    -> std::tuple<int, T>
 {
-    using Ts::operator()...;
-};
-template <class... Ts>
-overload(Ts...) -> overload<Ts...>;
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        return {0, str};
+    } else if constexpr (std::is_same_v<T, bool>) {
+        if (str == "true" || str == "1") {
+            return {0, true};
+        }
+        if (str == "false" || str == "0") {
+            return {0, false};
+        }
+        return {-EINVAL, false};
+    } else {
+        auto value = T{};
+        const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        if (ec == std::errc::result_out_of_range) {
+            return {-ERANGE, T{}};
+        }
+        if (ec != std::errc{} || ptr != str.data() + str.size()) {
+            return {-EINVAL, T{}};
+        }
+        return {0, value};
+    }
+}
+
+/* 8-bit integers are published as a single raw character, see to_string() */
+template <typename Byte, typename T>
+auto load_byte(std::string_view bytes) noexcept //
+    -> std::tuple<int, T>
+{
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        return {0, bytes};
+    } else {
+        if (bytes.size() != 1) {
+            return {-EINVAL, T{}};
+        }
+        const auto value = static_cast<Byte>(bytes[0]);
+        if constexpr (std::is_same_v<T, bool>) {
+            if (value != 0 && value != 1) {
+                return {-EINVAL, false};
+            }
+            return {0, value == 1};
+        } else if constexpr (std::is_integral_v<T>) {
+            if (!std::in_range<T>(value)) {
+                return {-ERANGE, T{}};
+            }
+            return {0, static_cast<T>(value)};
+        } else {
+            return {0, static_cast<T>(value)};
+        }
+    }
+}
+
+template <typename T>
+auto load(std::string_view bytes) noexcept //
+    -> std::tuple<int, T>
+{
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        return {0, bytes};
+    } else if constexpr (std::is_same_v<T, bool>) {
+        if (bytes.size() != 1) {
+            return {-EINVAL, false};
+        }
+        return {0, bytes[0] != '\0'};
+    } else {
+        if (bytes.size() != sizeof(T)) {
+            return {-EINVAL, T{}};
+        }
+        auto value = T{};
+        std::memcpy(&value, bytes.data(), sizeof(T));
+        return {0, value};
+    }
+}
+
+} // namespace
 
 FLECS_EXPORT variable_t::variable_t()
-    : _topic{}
-    , _value{}
-    , _encoding{}
-    , _timestamp{}
+    : _topic{""}
+    , _value{""}
+    , _encoding{""}
+    , _timestamp{""}
+    , _value_len{}
+    , _topic_len{}
+    , _encoding_len{}
+    , _timestamp_len{}
+    , _owned{}
 {}
 
 FLECS_EXPORT variable_t::variable_t(
     std::string key, std::string value, std::string encoding, std::string timestamp)
-    : _topic(std::move(key))
-    , _value(std::move(value))
-    , _encoding(std::move(encoding))
-    , _timestamp(std::move(timestamp))
-{}
+    : variable_t{}
+{
+    assign(key, value, encoding, timestamp);
+}
 
 FLECS_EXPORT variable_t::variable_t(
     const char* key, const char* value, const char* encoding, const char* timestamp)
-    : _topic(std::string_view{key})
-    , _value(std::string_view{value})
-    , _encoding(std::string_view{encoding})
-    , _timestamp(std::string_view{timestamp})
+    : variable_t{
+          std::string_view{key},
+          std::string_view{value},
+          std::string_view{encoding},
+          std::string_view{timestamp}}
 {}
 
-template <typename... Ts>
-auto as_string_view(const std::variant<Ts...>& var) //
-    -> std::string_view
+FLECS_EXPORT variable_t::variable_t(
+    std::string_view key,
+    std::string_view value,
+    std::string_view encoding,
+    std::string_view timestamp)
+    : _topic{key.data()}
+    , _value{value.data()}
+    , _encoding{encoding.data()}
+    , _timestamp{timestamp.data()}
+    , _value_len{value.size()}
+    , _topic_len{short_len(key)}
+    , _encoding_len{short_len(encoding)}
+    , _timestamp_len{short_len(timestamp)}
+    , _owned{}
+{}
+
+FLECS_EXPORT variable_t::variable_t(const variable_t& other)
+    : variable_t{}
 {
-    return std::visit(
-        overload{
-            [](const std::string& str) -> std::string_view { return str; },
-            [](const std::string_view& sv) -> std::string_view { return sv; }},
-        var);
+    /* copies always own their data, so that copies of views stay valid */
+    assign(other.topic(), other.value(), other.encoding(), other.timestamp());
+}
+
+FLECS_EXPORT variable_t::variable_t(variable_t&& other) noexcept
+    : variable_t{}
+{
+    swap(*this, other);
+}
+
+FLECS_EXPORT variable_t& variable_t::operator=(const variable_t& other)
+{
+    if (this != &other) {
+        auto tmp = variable_t{other};
+        swap(*this, tmp);
+    }
+    return *this;
+}
+
+FLECS_EXPORT variable_t& variable_t::operator=(variable_t&& other) noexcept
+{
+    swap(*this, other);
+    return *this;
+}
+
+FLECS_EXPORT variable_t::~variable_t()
+{
+    if (_owned) {
+        delete[] _topic;
+    }
 }
 
 FLECS_EXPORT auto variable_t::topic() const noexcept //
     -> std::string_view
 {
-    return as_string_view(_topic);
+    return {_topic, _topic_len};
 }
 
 FLECS_EXPORT auto variable_t::value() const noexcept //
     -> std::string_view
 {
-    return as_string_view(_value);
+    return {_value, _value_len};
 }
 
 FLECS_EXPORT auto variable_t::len() const noexcept //
     -> std::size_t
 {
-    return value().size();
+    return _value_len;
 }
 
 FLECS_EXPORT auto variable_t::encoding() const noexcept //
     -> std::string_view
 {
-    return as_string_view(_encoding);
+    return {_encoding, _encoding_len};
 }
 
 FLECS_EXPORT auto variable_t::timestamp() const noexcept //
     -> std::string_view
 {
-    return as_string_view(_timestamp);
+    return {_timestamp, _timestamp_len};
+}
+
+template <typename T>
+FLECS_EXPORT auto variable_t::try_as() const noexcept //
+    -> std::tuple<int, T>
+{
+    if (encoding() == "text/plain;int8") {
+        return load_byte<std::int8_t, T>(value());
+    }
+    if (encoding() == "text/plain;uint8") {
+        return load_byte<std::uint8_t, T>(value());
+    }
+    if (is_text_encoding(encoding())) {
+        return parse<T>(value());
+    }
+    if (is_binary_encoding(encoding())) {
+        return load<T>(value());
+    }
+    return {-ENOTSUP, T{}};
 }
 
+template auto variable_t::try_as<bool>() const noexcept -> std::tuple<int, bool>;
+template auto variable_t::try_as<std::int8_t>() const noexcept -> std::tuple<int, std::int8_t>;
+template auto variable_t::try_as<std::int16_t>() const noexcept -> std::tuple<int, std::int16_t>;
+template auto variable_t::try_as<std::int32_t>() const noexcept -> std::tuple<int, std::int32_t>;
+template auto variable_t::try_as<std::int64_t>() const noexcept -> std::tuple<int, std::int64_t>;
+template auto variable_t::try_as<std::uint8_t>() const noexcept -> std::tuple<int, std::uint8_t>;
+template auto variable_t::try_as<std::uint16_t>() const noexcept
+    -> std::tuple<int, std::uint16_t>;
+template auto variable_t::try_as<std::uint32_t>() const noexcept
+    -> std::tuple<int, std::uint32_t>;
+template auto variable_t::try_as<std::uint64_t>() const noexcept
+    -> std::tuple<int, std::uint64_t>;
+template auto variable_t::try_as<float>() const noexcept -> std::tuple<int, float>;
+template auto variable_t::try_as<double>() const noexcept -> std::tuple<int, double>;
+template auto variable_t::try_as<std::string_view>() const noexcept
+    -> std::tuple<int, std::string_view>;
+
 FLECS_EXPORT auto variable_t::own() //
     -> void
 {
     if (!is_owned()) {
-        _topic = std::string{std::get<std::string_view>(_topic)};
-        _value = std::string{std::get<std::string_view>(_value)};
-        _encoding = std::string{std::get<std::string_view>(_encoding)};
-        _timestamp = std::string{std::get<std::string_view>(_timestamp)};
+        assign(topic(), value(), encoding(), timestamp());
     }
 }
 
 FLECS_EXPORT auto variable_t::is_owned() const noexcept //
     -> bool
 {
-    return std::holds_alternative<std::string>(_topic);
+    return _owned;
+}
+
+auto variable_t::assign(
+    std::string_view topic,
+    std::string_view value,
+    std::string_view encoding,
+    std::string_view timestamp) //
+    -> void
+{
+    const auto topic_len = short_len(topic);
+    const auto encoding_len = short_len(encoding);
+    const auto timestamp_len = short_len(timestamp);
+
+    auto* buf = new char[topic.size() + value.size() + encoding.size() + timestamp.size() + 4];
+    const auto copy = [&buf](std::string_view str) {
+        const auto* start = buf;
+        buf = std::copy(str.cbegin(), str.cend(), buf);
+        *buf++ = '\0';
+        return start;
+    };
+
+    /* the views may point into the buffer being replaced */
+    auto var = variable_t{};
+    var._topic = copy(topic);
+    var._value = copy(value);
+    var._encoding = copy(encoding);
+    var._timestamp = copy(timestamp);
+    var._value_len = value.size();
+    var._topic_len = topic_len;
+    var._encoding_len = encoding_len;
+    var._timestamp_len = timestamp_len;
+    var._owned = true;
+    swap(*this, var);
+}
+
+FLECS_EXPORT auto swap(variable_t& lhs, variable_t& rhs) noexcept //
+    -> void
+{
+    using std::swap;
+    swap(lhs._topic, rhs._topic);
+    swap(lhs._value, rhs._value);
+    swap(lhs._encoding, rhs._encoding);
+    swap(lhs._timestamp, rhs._timestamp);
+    swap(lhs._value_len, rhs._value_len);
+    swap(lhs._topic_len, rhs._topic_len);
+    swap(lhs._encoding_len, rhs._encoding_len);
+    swap(lhs._timestamp_len, rhs._timestamp_len);
+    swap(lhs._owned, rhs._owned);
 }
 
 } // namespace flunder
 
+namespace {
+
+template <typename T>
+auto variable_as(const variable_t* var, T* value) noexcept //
+    -> int
+{
+    const auto [res, v] = var->try_as<T>();
+    if (res == 0) {
+        *value = v;
+    }
+    return res;
+}
+
+} // namespace
+
 extern "C" {
 
 FLECS_EXPORT variable_t* flunder_variable_new(
@@ -154,6 +394,61 @@ FLECS_EXPORT const char* flunder_variable_timestamp(const variable_t* var)
     return var->timestamp().data();
 }
 
+FLECS_EXPORT int flunder_variable_as_bool(const variable_t* var, bool* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_int8(const variable_t* var, int8_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_int16(const variable_t* var, int16_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_int32(const variable_t* var, int32_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_int64(const variable_t* var, int64_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_uint8(const variable_t* var, uint8_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_uint16(const variable_t* var, uint16_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_uint32(const variable_t* var, uint32_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_uint64(const variable_t* var, uint64_t* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_float(const variable_t* var, float* value)
+{
+    return variable_as(var, value);
+}
+
+FLECS_EXPORT int flunder_variable_as_double(const variable_t* var, double* value)
+{
+    return variable_as(var, value);
+}
+
 FLECS_EXPORT void flunder_variable_destroy(variable_t* var)
 {
     delete var;
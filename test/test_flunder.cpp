@@ -13,13 +13,26 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
 #include <zenoh.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <condition_variable>
+#include <coroutine>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <map>
 #include <mutex>
 #include <thread>
 
 #include "flunder/client.h"
+#include "flunder/json.h"
 #include "flunder/to_string.h"
 
 static auto cv = std::condition_variable{};
@@ -485,3 +498,1401 @@ TEST(flunder, c)
     ASSERT_EQ(res, 0);
     flunder_client_destroy(client);
 }
+
+namespace {
+/* minimal eagerly started coroutine to drive the awaitables under test */
+struct coro_t
+{
+    struct promise_type
+    {
+        auto get_return_object() noexcept //
+            -> coro_t
+        {
+            return {};
+        }
+        auto initial_suspend() noexcept //
+            -> std::suspend_never
+        {
+            return {};
+        }
+        auto final_suspend() noexcept //
+            -> std::suspend_never
+        {
+            return {};
+        }
+        auto return_void() noexcept //
+            -> void
+        {}
+        auto unhandled_exception() //
+            -> void
+        {
+            std::terminate();
+        }
+    };
+};
+
+auto coro_get(flunder::client_t& client, std::promise<std::size_t>& promise) //
+    -> coro_t
+{
+    const auto [res, vars] = co_await client.async_get("flecs/flunder/test/coro/**");
+    promise.set_value(res == 0 ? vars.size() : 0);
+}
+
+auto coro_stream(
+    flunder::subscription_stream_t& stream, std::promise<std::string>& promise) //
+    -> coro_t
+{
+    auto var = co_await stream.next();
+    promise.set_value(var.has_value() ? std::string{var->value()} : std::string{});
+}
+
+auto coro_publish(flunder::client_t& client, std::promise<int>& promise) //
+    -> coro_t
+{
+    const auto res = co_await client.async_publish("flecs/flunder/test/coro/stream", 42);
+    promise.set_value(res);
+}
+
+/* unsubscribes and queries from within the coroutine, which runs outside of zenoh callbacks */
+auto coro_unsubscribe(
+    flunder::subscription_stream_t& stream,
+    flunder::client_t& client,
+    std::promise<int>& promise) //
+    -> coro_t
+{
+    const auto var = co_await stream.next();
+    stream.close();
+    const auto [res, vars] = co_await client.async_get("flecs/flunder/test/coro/**");
+    promise.set_value(var.has_value() ? res : -1);
+}
+} // namespace
+
+TEST(flunder, coro)
+{
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+
+    auto res = client.add_mem_storage("test-storage-coro", "flecs/flunder/test/coro/**");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    client.publish("flecs/flunder/test/coro/int", 1111);
+    client.publish("flecs/flunder/test/coro/float", 3.14);
+    usleep(100000);
+
+    {
+        auto promise = std::promise<std::size_t>{};
+        auto future = promise.get_future();
+        coro_get(client, promise);
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        ASSERT_EQ(future.get(), 2);
+    }
+
+    auto resumed = std::atomic<int>{};
+    client.set_executor([&resumed](std::coroutine_handle<> handle) {
+        ++resumed;
+        handle.resume();
+    });
+
+    auto stream = client.async_subscribe("flecs/flunder/test/coro/stream");
+    ASSERT_TRUE(stream.is_open());
+    {
+        auto promise = std::promise<std::string>{};
+        auto future = promise.get_future();
+        coro_stream(stream, promise);
+
+        auto publish_promise = std::promise<int>{};
+        coro_publish(client, publish_promise);
+        ASSERT_EQ(publish_promise.get_future().get(), 0);
+
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        ASSERT_EQ(future.get(), "42");
+    }
+    {
+        /* closing the stream resumes pending consumers without a value */
+        auto promise = std::promise<std::string>{};
+        auto future = promise.get_future();
+        coro_stream(stream, promise);
+        stream.close();
+        ASSERT_FALSE(stream.is_open());
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        ASSERT_TRUE(future.get().empty());
+    }
+    ASSERT_GE(resumed, 2);
+
+    res = client.remove_mem_storage("test-storage-coro");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, coro_unsubscribe)
+{
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+
+    auto res = client.add_mem_storage("test-storage-coro-unsub", "flecs/flunder/test/coro/**");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+
+    auto stream = client.async_subscribe("flecs/flunder/test/coro/unsubscribe");
+    ASSERT_TRUE(stream.is_open());
+
+    auto promise = std::promise<int>{};
+    auto future = promise.get_future();
+    coro_unsubscribe(stream, client, promise);
+    client.publish("flecs/flunder/test/coro/unsubscribe", 42);
+
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ASSERT_EQ(future.get(), 0);
+    ASSERT_FALSE(stream.is_open());
+
+    res = client.remove_mem_storage("test-storage-coro-unsub");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, subscribe_batch)
+{
+    auto client_1 = flunder::client_t{};
+    auto client_2 = flunder::client_t{};
+    client_1.connect("172.17.0.1", 7447);
+    client_2.connect("172.17.0.1", 7447);
+
+    auto batch_mutex = std::mutex{};
+    auto batch_cv = std::condition_variable{};
+    auto received = std::size_t{};
+    auto max_batch = std::size_t{};
+
+    auto res = client_1.subscribe_batch(
+        "flecs/flunder/test/batch/**",
+        [&](flunder::client_t* client, std::span<const flunder::variable_t> vars) {
+            ASSERT_EQ(client, &client_1);
+            auto lock = std::lock_guard{batch_mutex};
+            received += vars.size();
+            max_batch = std::max(max_batch, vars.size());
+            batch_cv.notify_all();
+        },
+        flunder::batch_options_t{4, std::chrono::milliseconds{10}});
+    ASSERT_EQ(res, 0);
+    /* attempt to subscribe again */
+    res = client_1.subscribe_batch("flecs/flunder/test/batch/**", {});
+    ASSERT_EQ(res, -1);
+
+    for (int i = 0; i < 10; ++i) {
+        res = client_2.publish("flecs/flunder/test/batch/int", i);
+        ASSERT_EQ(res, 0);
+    }
+
+    {
+        auto lock = std::unique_lock{batch_mutex};
+        ASSERT_TRUE(batch_cv.wait_for(lock, std::chrono::seconds(5), [&] { return received == 10; }));
+        ASSERT_LE(max_batch, 4);
+    }
+
+    res = client_1.unsubscribe("flecs/flunder/test/batch/**");
+    ASSERT_EQ(res, 0);
+
+    /* without a delay, every sample is delivered on its own and none is held back */
+    received = 0;
+    max_batch = 0;
+    res = client_1.subscribe_batch(
+        "flecs/flunder/test/batch/**",
+        [&](flunder::client_t*, std::span<const flunder::variable_t> vars) {
+            auto lock = std::lock_guard{batch_mutex};
+            received += vars.size();
+            max_batch = std::max(max_batch, vars.size());
+            batch_cv.notify_all();
+        },
+        flunder::batch_options_t{4, std::chrono::milliseconds{0}});
+    ASSERT_EQ(res, 0);
+
+    for (int i = 0; i < 3; ++i) {
+        res = client_2.publish("flecs/flunder/test/batch/int", i);
+        ASSERT_EQ(res, 0);
+    }
+
+    {
+        auto lock = std::unique_lock{batch_mutex};
+        ASSERT_TRUE(batch_cv.wait_for(lock, std::chrono::seconds(5), [&] { return received == 3; }));
+        ASSERT_EQ(max_batch, 1);
+    }
+
+    res = client_1.unsubscribe("flecs/flunder/test/batch/**");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, subscribe_reentrant)
+{
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+
+    /* publishing from the callback may dispatch the next sample before the callback returns */
+    auto mutex = std::mutex{};
+    auto received = std::vector<std::string>{};
+    auto valid = std::atomic<bool>{true};
+    auto res = client.subscribe(
+        "flecs/flunder/test/reentrant",
+        [&](flunder::client_t* client, const flunder::variable_t* var) {
+            const auto value = std::string{var->value()};
+            if (value == "ping") {
+                client->publish("flecs/flunder/test/reentrant", "pong-pong-pong-pong-pong");
+            }
+            if (var->value() != value) {
+                valid = false;
+            }
+            auto lock = std::lock_guard{mutex};
+            received.push_back(value);
+        });
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+
+    client.publish("flecs/flunder/test/reentrant", "ping");
+    usleep(200000);
+    {
+        auto lock = std::lock_guard{mutex};
+        std::sort(received.begin(), received.end());
+        ASSERT_EQ(received, (std::vector<std::string>{"ping", "pong-pong-pong-pong-pong"}));
+    }
+    ASSERT_TRUE(valid);
+
+    res = client.unsubscribe("flecs/flunder/test/reentrant");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, get_stream)
+{
+    auto client = flunder::client_t{};
+    {
+        /* Not connected -> error */
+        const auto [res, stream] = client.get_stream("**");
+        ASSERT_EQ(res, -1);
+        ASSERT_FALSE(stream.is_open());
+    }
+
+    client.connect("172.17.0.1", 7447);
+    auto res = client.add_mem_storage("test-storage-stream", "flecs/flunder/test/stream/**");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    for (int i = 0; i < 8; ++i) {
+        client.publish("flecs/flunder/test/stream/" + std::to_string(i), i);
+    }
+    usleep(100000);
+
+    {
+        auto [res, stream] = client.get_stream("flecs/flunder/test/stream/**", 2);
+        ASSERT_EQ(res, 0);
+        auto n = std::size_t{};
+        for (const auto& var : stream) {
+            ASSERT_TRUE(var.topic().starts_with("flecs/flunder/test/stream/"));
+            ++n;
+        }
+        ASSERT_EQ(n, 8);
+        ASSERT_FALSE(stream.is_open());
+    }
+    {
+        /* cancel after the first reply */
+        auto n = std::size_t{};
+        res = client.get(
+            "flecs/flunder/test/stream/**",
+            [&n](const flunder::variable_t*) {
+                ++n;
+                return false;
+            },
+            1);
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(n, 1);
+    }
+    {
+        auto stream = flunder_get_stream_new(&client, "flecs/flunder/test/stream/**", 4);
+        ASSERT_NE(stream, nullptr);
+        auto n = std::size_t{};
+        while (flunder_get_stream_next(stream)) {
+            ++n;
+        }
+        ASSERT_EQ(n, 8);
+        flunder_get_stream_destroy(stream);
+    }
+
+    res = client.remove_mem_storage("test-storage-stream");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, result_set)
+{
+    /* owned variables keep all strings in one buffer, terminated for the C API */
+    auto var = flunder::variable_t{
+        std::string{"flecs/flunder/test/result_set"},
+        std::string{"value"},
+        std::string{"text/plain"},
+        std::string{"1"}};
+    ASSERT_TRUE(var.is_owned());
+    ASSERT_EQ(var.value().data()[var.len()], '\0');
+    ASSERT_EQ(var.value().data(), var.topic().data() + var.topic().size() + 1);
+    auto view = flunder::variable_t{var.topic(), var.value(), var.encoding(), var.timestamp()};
+    ASSERT_FALSE(view.is_owned());
+    /* copies of views own their data */
+    const auto copy = view;
+    ASSERT_TRUE(copy.is_owned());
+    ASSERT_NE(copy.topic().data(), var.topic().data());
+    ASSERT_EQ(copy.topic(), var.topic());
+    view.own();
+    ASSERT_TRUE(view.is_owned());
+    ASSERT_NE(view.topic().data(), var.topic().data());
+
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    client.add_mem_storage("flunder-test-result-set", "flecs/flunder/test/result_set/**");
+    usleep(100000);
+    for (auto i = 0; i < 100; ++i) {
+        client.publish("flecs/flunder/test/result_set/" + std::to_string(i), std::to_string(i));
+    }
+    usleep(100000);
+
+    const auto query = flunder::query_t{"flecs/flunder/test/result_set/**"};
+    auto [res, results] = client.get_result_set(query);
+    ASSERT_EQ(res, 0);
+    ASSERT_EQ(results.size(), 100);
+    const auto [get_res, vars] = client.get("flecs/flunder/test/result_set/**");
+    ASSERT_EQ(get_res, 0);
+    ASSERT_EQ(vars.size(), results.size());
+
+    /* variables stay valid when the set is moved */
+    const auto moved = std::move(results);
+    for (const auto& var : moved) {
+        ASSERT_FALSE(var.is_owned());
+        ASSERT_TRUE(var.topic().starts_with("flecs/flunder/test/result_set/"));
+        ASSERT_EQ(var.topic().substr(var.topic().rfind('/') + 1), var.value());
+    }
+
+    void* c_results = nullptr;
+    res = flunder_get_result_set(&client, "flecs/flunder/test/result_set/**", &c_results);
+    ASSERT_EQ(res, 0);
+    ASSERT_NE(c_results, nullptr);
+    ASSERT_EQ(flunder_result_set_size(c_results), 100);
+    const auto* first = flunder_result_set_at(c_results, 0);
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(flunder_variable_next(first), flunder_result_set_at(c_results, 1));
+    ASSERT_EQ(flunder_result_set_at(c_results, 100), nullptr);
+    flunder_result_set_destroy(c_results);
+
+    client.remove_mem_storage("flunder-test-result-set");
+}
+
+TEST(flunder, result_set_zero_copy)
+{
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    client.add_mem_storage("flunder-test-zero-copy", "flecs/flunder/test/zero_copy/**");
+    usleep(100000);
+    auto blob = std::string(1024 * 1024, '\0');
+    for (auto i = std::size_t{}; i < blob.size(); ++i) {
+        blob[i] = static_cast<char>(i * 31);
+    }
+    client.publish("flecs/flunder/test/zero_copy/blob", blob.data(), blob.size());
+    usleep(200000);
+
+    const auto query = flunder::query_t{"flecs/flunder/test/zero_copy/**"};
+    auto [res, borrowed] = client.get_result_set(query, flunder::result_mode_t::zero_copy);
+    ASSERT_EQ(res, 0);
+    ASSERT_EQ(borrowed.size(), 1);
+    ASSERT_EQ(borrowed[0].topic(), "flecs/flunder/test/zero_copy/blob");
+    ASSERT_EQ(borrowed[0].encoding(), "application/octet-stream");
+    ASSERT_EQ(borrowed[0].value(), blob);
+    ASSERT_FALSE(borrowed[0].timestamp().empty());
+
+    /* the payload is not copied into the arena, and stays valid when the set is moved */
+    const auto [copy_res, copied] = client.get_result_set(query);
+    ASSERT_EQ(copy_res, 0);
+    ASSERT_GT(copied.memory_usage(), blob.size());
+    ASSERT_LT(borrowed.memory_usage(), blob.size() / 8);
+    const auto moved = std::move(borrowed);
+    ASSERT_EQ(moved[0].value(), blob);
+
+    client.remove_mem_storage("flunder-test-zero-copy");
+}
+
+TEST(flunder, variable_as)
+{
+    const auto text = flunder::variable_t{"topic", "42", "text/plain;int64", ""};
+    ASSERT_EQ(text.as<std::int64_t>(), 42);
+    ASSERT_EQ(text.as<double>(), 42.0);
+    ASSERT_EQ(std::get<0>(text.try_as<bool>()), -EINVAL);
+    const auto large = flunder::variable_t{"topic", "300", "text/plain;int16", ""};
+    ASSERT_EQ(std::get<0>(large.try_as<std::int8_t>()), -ERANGE);
+    ASSERT_EQ(
+        std::get<0>(flunder::variable_t("topic", "1.5", "text/plain;float64", "").try_as<int>()),
+        -EINVAL);
+    ASSERT_EQ(flunder::variable_t("topic", "", "text/plain;int32", "").as<int>(-1), -1);
+    ASSERT_EQ(
+        std::get<0>(flunder::variable_t("topic", "1", "application/json", "").try_as<int>()),
+        -ENOTSUP);
+
+    const auto d = 2.5;
+    const auto binary = flunder::variable_t{
+        std::string_view{"topic"},
+        std::string_view{reinterpret_cast<const char*>(&d), sizeof(d)},
+        std::string_view{"application/octet-stream"},
+        std::string_view{}};
+    ASSERT_EQ(binary.as<double>(), 2.5);
+    ASSERT_EQ(std::get<0>(binary.try_as<float>()), -EINVAL);
+
+    auto i = std::int64_t{};
+    ASSERT_EQ(flunder_variable_as_int64(&text, &i), 0);
+    ASSERT_EQ(i, 42);
+    auto f = 1.0f;
+    ASSERT_EQ(flunder_variable_as_float(&binary, &f), -EINVAL);
+    ASSERT_EQ(f, 1.0f);
+
+    /* 8-bit integers are a single raw byte */
+    const auto byte = flunder::variable_t{"topic", "5", "text/plain;uint8", ""};
+    ASSERT_EQ(byte.as<std::uint8_t>(), 53);
+    ASSERT_EQ(std::get<0>(byte.try_as<std::int8_t>()), 0);
+    const auto negative = flunder::variable_t{"topic", "\xfb", "text/plain;int8", ""};
+    ASSERT_EQ(negative.as<std::int32_t>(), -5);
+    ASSERT_EQ(std::get<0>(negative.try_as<std::uint8_t>()), -ERANGE);
+    ASSERT_EQ(
+        std::get<0>(flunder::variable_t("topic", "-5", "text/plain;int8", "").try_as<int>()),
+        -EINVAL);
+    auto i8 = std::int8_t{};
+    ASSERT_EQ(flunder_variable_as_int8(&negative, &i8), 0);
+    ASSERT_EQ(i8, -5);
+    auto u8 = std::uint8_t{};
+    ASSERT_EQ(flunder_variable_as_uint8(&byte, &u8), 0);
+    ASSERT_EQ(u8, 53);
+
+    /* values round-trip through publish */
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    client.add_mem_storage("flunder-test-variable-as", "flecs/flunder/test/variable_as/**");
+    usleep(100000);
+    client.publish("flecs/flunder/test/variable_as/int8", std::int8_t{-5});
+    client.publish("flecs/flunder/test/variable_as/uint8", std::uint8_t{200});
+    client.publish("flecs/flunder/test/variable_as/int16", std::int16_t{-5});
+    client.publish("flecs/flunder/test/variable_as/uint64", std::uint64_t{1} << 63);
+    client.publish("flecs/flunder/test/variable_as/float", 0.25f);
+    client.publish("flecs/flunder/test/variable_as/bool", true);
+    usleep(100000);
+
+    const auto [res, vars] = client.get("flecs/flunder/test/variable_as/**");
+    ASSERT_EQ(res, 0);
+    ASSERT_EQ(vars.size(), 6);
+    for (const auto& var : vars) {
+        if (var.topic().ends_with("uint8")) {
+            ASSERT_EQ(var.as<std::uint8_t>(), 200);
+        } else if (var.topic().ends_with("int8")) {
+            ASSERT_EQ(var.as<std::int8_t>(), -5);
+        } else if (var.topic().ends_with("int16")) {
+            ASSERT_EQ(var.as<std::int16_t>(), -5);
+        } else if (var.topic().ends_with("uint64")) {
+            ASSERT_EQ(var.as<std::uint64_t>(), std::uint64_t{1} << 63);
+        } else if (var.topic().ends_with("float")) {
+            ASSERT_EQ(var.as<float>(), 0.25f);
+        } else {
+            ASSERT_TRUE(var.as<bool>());
+        }
+    }
+
+    client.remove_mem_storage("flunder-test-variable-as");
+}
+
+TEST(flunder, column_set)
+{
+    const auto vars = std::vector<flunder::variable_t>{
+        {"topic/int", "42", "text/plain;int64", "1700000000000000000"},
+        {"topic/double", "-1234567.125", "text/plain;float64", "1700000000000000001"},
+        {"topic/exponent", "2.5e-3", "text/plain;float64", "1700000000000000002"},
+        {"topic/string", "Hello, FLECS!", "text/plain", "1700000000000000003"},
+        {"topic/bool", "false", "text/plain;bool", "1700000000000000004"},
+        {"topic/json", "{}", "application/json", "1700000000000000005"},
+    };
+    auto columns = flunder::column_set_t{};
+    columns.append(vars);
+    ASSERT_EQ(columns.size(), 6);
+    ASSERT_EQ(columns.valid_count(), 4);
+    ASSERT_EQ(columns.key(1), "topic/double");
+    ASSERT_EQ(columns.timestamps()[5], std::uint64_t{1700000000000000005});
+    ASSERT_EQ(columns.values()[0], 42.0);
+    ASSERT_EQ(columns.values()[1], -1234567.125);
+    ASSERT_EQ(columns.values()[2], 2.5e-3);
+    ASSERT_FALSE(columns.valid(3));
+    ASSERT_EQ(columns.values()[3], 0.0);
+    ASSERT_TRUE(columns.valid(4));
+    ASSERT_FALSE(columns.valid(5));
+
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    client.add_mem_storage("flunder-test-column-set", "flecs/flunder/test/column_set/**");
+    usleep(100000);
+    for (auto i = 0; i < 100; ++i) {
+        client.publish("flecs/flunder/test/column_set/" + std::to_string(i), i * 0.5);
+    }
+    usleep(100000);
+
+    const auto query = flunder::query_t{"flecs/flunder/test/column_set/**"};
+    const auto [res, results] = client.get_columns(query);
+    ASSERT_EQ(res, 0);
+    ASSERT_EQ(results.size(), 100);
+    ASSERT_EQ(results.valid_count(), 100);
+    for (auto row = std::size_t{}; row < results.size(); ++row) {
+        const auto key = results.key(row);
+        const auto i = std::stoi(std::string{key.substr(key.rfind('/') + 1)});
+        ASSERT_EQ(results.values()[row], i * 0.5);
+        ASSERT_GT(results.timestamps()[row], std::uint64_t{});
+    }
+
+    client.remove_mem_storage("flunder-test-column-set");
+}
+
+TEST(flunder, json)
+{
+    const auto doc = nlohmann::json{
+        {"name", "flunder"},
+        {"version", 3},
+        {"ratio", 0.75},
+        {"enabled", true},
+        {"endpoints", {"tcp/172.17.0.1:7447", "tcp/172.17.0.2:7447"}},
+        {"limits", {{"depth", 64}, {"timeout", nullptr}}},
+    };
+
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    client.add_mem_storage("flunder-test-json", "flecs/flunder/test/json/**");
+    usleep(100000);
+    const auto formats = {
+        flunder::json_format_t::text,
+        flunder::json_format_t::cbor,
+        flunder::json_format_t::msgpack,
+    };
+    for (const auto format : formats) {
+        const auto topic = "flecs/flunder/test/json/" + std::to_string(static_cast<int>(format));
+        ASSERT_EQ(flunder::publish_json(client, topic, doc, format), 0);
+    }
+    usleep(100000);
+
+    const auto [res, vars] = client.get("flecs/flunder/test/json/**");
+    ASSERT_EQ(res, 0);
+    ASSERT_EQ(vars.size(), 3);
+    for (const auto& var : vars) {
+        const auto json = flunder::as_json(var);
+        ASSERT_TRUE(json.format().has_value());
+        ASSERT_EQ(static_cast<int>(*json.format()), var.topic().back() - '0');
+        ASSERT_NE(json.get(), nullptr);
+        ASSERT_EQ(*json.get(), doc);
+    }
+
+    const auto text = flunder::variable_t{"topic", "42", "text/plain;int32", ""};
+    ASSERT_EQ(flunder::as_json(text).get(), nullptr);
+    ASSERT_EQ(std::get<0>(flunder::try_as_json(text)), -ENOTSUP);
+    const auto malformed = flunder::variable_t{"topic", "{\"a\":", "application/json", ""};
+    ASSERT_EQ(std::get<0>(flunder::try_as_json(malformed)), -EINVAL);
+
+    client.remove_mem_storage("flunder-test-json");
+}
+
+TEST(flunder, get_many)
+{
+    auto client = flunder::client_t{};
+    const auto topics = std::array<std::string_view, 3>{
+        "flecs/flunder/test/many/a/**",
+        "flecs/flunder/test/many/b/**",
+        "flecs/flunder/test/many/none/**"};
+    {
+        /* Not connected -> error, but one (empty) result per topic */
+        const auto [res, results] = client.get_many(topics);
+        ASSERT_EQ(res, -1);
+        ASSERT_EQ(results.size(), topics.size());
+    }
+
+    client.connect("172.17.0.1", 7447);
+    auto res = client.add_mem_storage("test-storage-many", "flecs/flunder/test/many/**");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    client.publish("flecs/flunder/test/many/a/1", 1);
+    client.publish("flecs/flunder/test/many/a/2", 2);
+    client.publish("flecs/flunder/test/many/b/1", 3);
+    usleep(100000);
+
+    {
+        const auto [res, results] = client.get_many(topics, std::chrono::seconds{5});
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(results.size(), topics.size());
+        ASSERT_EQ(results[0].size(), 2);
+        ASSERT_EQ(results[1].size(), 1);
+        ASSERT_EQ(results[1][0].value(), "3");
+        ASSERT_TRUE(results[2].empty());
+    }
+    {
+        /* invalid key expressions are reported instead of yielding no data */
+        const auto invalid = std::array<std::string_view, 2>{
+            "flecs/flunder/test/many/a/**",
+            "flecs/flunder/test/many//b"};
+        const auto [res, results] = client.get_many(invalid, std::chrono::seconds{5});
+        ASSERT_EQ(res, -EINVAL);
+        ASSERT_EQ(results.size(), invalid.size());
+        ASSERT_EQ(results[0].size(), 2);
+        ASSERT_TRUE(results[1].empty());
+    }
+
+    res = client.remove_mem_storage("test-storage-many");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, query)
+{
+    {
+        auto query = flunder::query_t{"/flecs/flunder/test/query/**"};
+        ASSERT_EQ(query.topic(), "flecs/flunder/test/query/**");
+        ASSERT_TRUE(query.parameters().empty());
+
+        query.since(std::chrono::minutes{5}).param("custom", "1").limit(10).ordered();
+        ASSERT_EQ(query.parameters(), "_time=[now(-300s)..];custom=1");
+        ASSERT_EQ(query.limit(), 10);
+        ASSERT_TRUE(query.is_ordered());
+
+        const auto start = std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}};
+        query.time_range(start, start + std::chrono::milliseconds{1500});
+        ASSERT_EQ(
+            query.parameters(),
+            "_time=[2023-11-14T22:13:20.000000000Z..2023-11-14T22:13:21.500000000Z];custom=1");
+    }
+    {
+        /* keys_only() replaces the parameter set explicitly */
+        auto query = flunder::query_t{"flecs/flunder/test/query/**"};
+        query.param(flunder::FLUNDER_KEYS_ONLY_PARAM, "false").param("custom", "1").keys_only();
+        ASSERT_EQ(query.parameters(), "custom=1;flunder_keys_only=true");
+        query.keys_only(false);
+        ASSERT_EQ(query.parameters(), "flunder_keys_only=false;custom=1");
+    }
+
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    auto res = client.add_mem_storage("test-storage-query", "flecs/flunder/test/query/**");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    for (const auto key : {"c", "a", "b"}) {
+        client.publish(std::string{"flecs/flunder/test/query/"} + key, key);
+        usleep(10000);
+    }
+    usleep(100000);
+
+    {
+        /* replies ordered by timestamp, limited to the two oldest ones */
+        const auto [res, vars] =
+            client.get(flunder::query_t{"flecs/flunder/test/query/**"}.ordered().limit(2));
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 2);
+        ASSERT_EQ(vars[0].value(), "c");
+        ASSERT_EQ(vars[1].value(), "a");
+    }
+    {
+        const auto [res, vars] = client.get(flunder::query_t{"flecs/flunder/test/query/**"}.limit(1));
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 1);
+    }
+
+    res = client.remove_mem_storage("test-storage-query");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, query_consolidation)
+{
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    auto res = client.add_mem_storage("test-storage-consolidation-1", "flecs/flunder/test/cons/**");
+    ASSERT_EQ(res, 0);
+    res = client.add_mem_storage("test-storage-consolidation-2", "flecs/flunder/test/cons/**");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    client.publish("flecs/flunder/test/cons/a", "a");
+    client.publish("flecs/flunder/test/cons/b", "b");
+    usleep(100000);
+
+    {
+        /* both overlapping storages reply for each key */
+        const auto [res, vars] = client.get(flunder::query_t{"flecs/flunder/test/cons/**"}
+                                                .consolidation(flunder::consolidation_t::none));
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 4);
+    }
+    {
+        const auto [res, vars] = client.get(flunder::query_t{"flecs/flunder/test/cons/**"}
+                                                .consolidation(flunder::consolidation_t::latest)
+                                                .timeout(std::chrono::seconds{1}));
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 2);
+    }
+
+    res = client.remove_mem_storage("test-storage-consolidation-1");
+    ASSERT_EQ(res, 0);
+    res = client.remove_mem_storage("test-storage-consolidation-2");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, list_keys)
+{
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    auto res = client.add_mem_storage("test-storage-list-keys", "flecs/flunder/test/keys/**");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    client.publish("flecs/flunder/test/keys/a", std::string(4096, 'a'));
+    client.publish("flecs/flunder/test/keys/b/c", 1234);
+    usleep(100000);
+
+    const auto [get_res, vars] = client.list_keys("flecs/flunder/test/keys");
+    ASSERT_EQ(get_res, 0);
+    ASSERT_EQ(vars.size(), 2);
+    for (const auto& var : vars) {
+        ASSERT_TRUE(var.value().empty());
+        ASSERT_FALSE(var.encoding().empty());
+        ASSERT_FALSE(var.timestamp().empty());
+    }
+
+    res = client.remove_mem_storage("test-storage-list-keys");
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, serve)
+{
+    auto server = flunder::client_t{};
+    server.connect("172.17.0.1", 7447);
+    auto res = server.serve("flecs/flunder/test/serve/**", [](flunder::reply_builder_t& reply) {
+        reply.reply("flecs/flunder/test/serve/a", "a");
+        reply.reply(
+            "flecs/flunder/test/serve/b",
+            std::string(4096, 'b'),
+            "application/octet-stream");
+    });
+    ASSERT_EQ(res, 0);
+    res = server.serve("flecs/flunder/test/serve/**", [](flunder::reply_builder_t&) {});
+    ASSERT_EQ(res, -1);
+    usleep(100000);
+
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    {
+        const auto [res, vars] = client.get("flecs/flunder/test/serve/**");
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 2);
+        for (const auto& var : vars) {
+            if (var.topic() == "flecs/flunder/test/serve/a") {
+                ASSERT_EQ(var.value(), "a");
+                ASSERT_EQ(var.encoding(), "text/plain");
+            } else {
+                ASSERT_EQ(var.value(), std::string(4096, 'b'));
+                ASSERT_EQ(var.encoding(), "application/octet-stream");
+            }
+            ASSERT_FALSE(var.timestamp().empty());
+        }
+    }
+    {
+        const auto [res, vars] = client.list_keys("flecs/flunder/test/serve");
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 2);
+        ASSERT_TRUE(vars[0].value().empty());
+        ASSERT_TRUE(vars[1].value().empty());
+    }
+    {
+        /* only the exact parameter set to true requests keys only */
+        const auto query = flunder::query_t{"flecs/flunder/test/serve/a"}
+                               .param("x_flunder_keys_only", "true")
+                               .param("flunder_keys_only", "false");
+        const auto [res, vars] = client.get(query);
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 1);
+        ASSERT_EQ(vars[0].value(), "a");
+    }
+
+    res = server.unserve("flecs/flunder/test/serve/**");
+    ASSERT_EQ(res, 0);
+    res = server.unserve("flecs/flunder/test/serve/**");
+    ASSERT_EQ(res, -1);
+}
+
+TEST(flunder, local_storage)
+{
+    const auto path = std::filesystem::temp_directory_path() / "flunder-test-local-storage";
+    std::filesystem::remove_all(path);
+
+    auto options = flunder::local_storage_options_t{};
+    options.path = path.string();
+    options.segment_size = 64 * 1024;
+
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    auto res = client.add_local_storage("test-local", "flecs/flunder/test/local/**", options);
+    ASSERT_EQ(res, 0);
+    res = client.add_local_storage("test-local", "flecs/flunder/test/local/**", options);
+    ASSERT_EQ(res, -1);
+    usleep(100000);
+    for (auto i = 0; i < 3; ++i) {
+        client.publish("flecs/flunder/test/local/a", std::to_string(i));
+        usleep(10000);
+    }
+    client.publish("flecs/flunder/test/local/b", "b");
+    usleep(100000);
+
+    {
+        const auto [res, vars] = client.get("flecs/flunder/test/local/**");
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 2);
+    }
+    {
+        const auto [res, vars] = client.get(flunder::query_t{"flecs/flunder/test/local/a"}
+                                                .since(std::chrono::minutes{1})
+                                                .ordered());
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 3);
+        ASSERT_EQ(vars[0].value(), "0");
+        ASSERT_EQ(vars[2].value(), "2");
+    }
+
+    /* records are recovered from disk */
+    res = client.remove_local_storage("test-local");
+    ASSERT_EQ(res, 0);
+    res = client.add_local_storage("test-local", "flecs/flunder/test/local/**", options);
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    {
+        const auto [res, vars] = client.get("flecs/flunder/test/local/a");
+        ASSERT_EQ(res, 0);
+        ASSERT_EQ(vars.size(), 1);
+        ASSERT_EQ(vars[0].value(), "2");
+    }
+
+    res = client.remove_local_storage("test-local");
+    ASSERT_EQ(res, 0);
+    std::filesystem::remove_all(path);
+}
+
+TEST(flunder, history)
+{
+    auto history = flunder::history_t{std::chrono::seconds{10}, 16};
+
+    /* 20 s of samples at 10 Hz; the first 10 s fall out of the retention */
+    const auto start = std::int64_t{1'700'000'000'000'000'000};
+    const auto period = std::int64_t{100'000'000};
+    for (auto i = 0; i < 200; ++i) {
+        const auto res = history.append("history/a", {start + i * period, 20.0 + (i % 7) * 0.1});
+        ASSERT_EQ(res, 0);
+    }
+    ASSERT_EQ(history.append("history/a", {start, 0.0}), -1);
+    ASSERT_GE(history.size("history/a"), 100);
+    ASSERT_LT(history.size("history/a"), 120);
+    ASSERT_LT(history.memory_usage(), history.size("history/a") * sizeof(flunder::sample_t));
+
+    const auto samples = history.range("history/a", start + 150 * period, start + 159 * period);
+    ASSERT_EQ(samples.size(), 10);
+    for (auto i = 0; i < 10; ++i) {
+        ASSERT_EQ(samples[i].timestamp, start + (150 + i) * period);
+        ASSERT_EQ(samples[i].value, 20.0 + ((150 + i) % 7) * 0.1);
+    }
+    ASSERT_TRUE(history.range("history/b", 0, std::numeric_limits<std::int64_t>::max()).empty());
+
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+    auto res = history.record(client, "flecs/flunder/test/history");
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    for (auto i = 0; i < 5; ++i) {
+        client.publish("flecs/flunder/test/history", 1.5 * i);
+        usleep(10000);
+    }
+    usleep(100000);
+    res = client.unsubscribe("flecs/flunder/test/history");
+    ASSERT_EQ(res, 0);
+
+    const auto recorded = history.range(
+        "flecs/flunder/test/history",
+        std::numeric_limits<std::int64_t>::min(),
+        std::numeric_limits<std::int64_t>::max());
+    ASSERT_EQ(recorded.size(), 5);
+    ASSERT_EQ(recorded[4].value, 6.0);
+}
+
+TEST(flunder, aggregate)
+{
+    auto history = flunder::history_t{std::chrono::hours{1}, 16};
+
+    /* 60 s of samples at 10 Hz, aggregated into 10 s buckets */
+    const auto start = std::int64_t{1'700'000'000'000'000'000};
+    const auto period = std::int64_t{100'000'000};
+    for (auto i = 0; i < 600; ++i) {
+        ASSERT_EQ(history.append("aggregate/a", {start + i * period, static_cast<double>(i)}), 0);
+    }
+
+    auto aggregator = flunder::aggregator_t{std::chrono::seconds{10}};
+    history.aggregate(
+        "aggregate/a",
+        std::numeric_limits<std::int64_t>::min(),
+        std::numeric_limits<std::int64_t>::max(),
+        aggregator);
+    const auto buckets = aggregator.take();
+    ASSERT_EQ(buckets.size(), 6);
+    for (auto b = std::size_t{}; b < buckets.size(); ++b) {
+        const auto first = static_cast<double>(b * 100);
+        ASSERT_EQ(buckets[b].start, start + static_cast<std::int64_t>(b) * 100 * period);
+        ASSERT_EQ(buckets[b].count, 100);
+        ASSERT_EQ(buckets[b].min, first);
+        ASSERT_EQ(buckets[b].max, first + 99.0);
+        ASSERT_EQ(buckets[b].first, first);
+        ASSERT_EQ(buckets[b].last, first + 99.0);
+        ASSERT_EQ(buckets[b].avg(), first + 49.5);
+    }
+    ASSERT_TRUE(aggregator.buckets().empty());
+
+    /* partial range cuts into blocks, which are decoded instead of merged */
+    history.aggregate("aggregate/a", start + 95 * period, start + 104 * period, aggregator);
+    ASSERT_EQ(aggregator.buckets().size(), 2);
+    ASSERT_EQ(aggregator.buckets()[0].count, 5);
+    ASSERT_EQ(aggregator.buckets()[0].sum, 95.0 + 96.0 + 97.0 + 98.0 + 99.0);
+    ASSERT_EQ(aggregator.buckets()[1].count, 5);
+    ASSERT_EQ(aggregator.buckets()[1].min, 100.0);
+
+    const auto vars = std::vector<flunder::variable_t>{
+        {"aggregate/b", "3.5", "text/plain", std::to_string(start + 2 * period)},
+        {"aggregate/b", "1.5", "text/plain", std::to_string(start)},
+        {"aggregate/b", "no number", "text/plain", std::to_string(start + period)},
+        {"aggregate/c", "7", "text/plain", std::to_string(start)},
+    };
+    const auto res = flunder::aggregate(vars, std::chrono::seconds{1});
+    ASSERT_EQ(res.size(), 2);
+    ASSERT_EQ(res.at("aggregate/b").size(), 1);
+    ASSERT_EQ(res.at("aggregate/b")[0].count, 2);
+    ASSERT_EQ(res.at("aggregate/b")[0].first, 1.5);
+    ASSERT_EQ(res.at("aggregate/b")[0].last, 3.5);
+    ASSERT_EQ(res.at("aggregate/c")[0].avg(), 7.0);
+}
+
+TEST(flunder, outbox)
+{
+    const auto path = std::filesystem::temp_directory_path() / "flunder-test-outbox";
+    std::filesystem::remove(path);
+
+    auto options = flunder::outbox_options_t{};
+    options.path = path.string();
+    options.max_size = 64 * 1024;
+    options.replay_rate = 100;
+
+    auto client = flunder::client_t{};
+    auto res = client.enable_outbox(options);
+    ASSERT_EQ(res, 0);
+    res = client.enable_outbox(options);
+    ASSERT_EQ(res, -1);
+
+    /* publishes while disconnected are buffered instead of failing */
+    const auto before = std::chrono::system_clock::now();
+    for (auto i = 0; i < 5; ++i) {
+        res = client.publish("flecs/flunder/test/outbox", i);
+        ASSERT_EQ(res, 0);
+        usleep(10000);
+    }
+    auto stats = client.outbox_stats();
+    ASSERT_EQ(stats.buffered, 5);
+    ASSERT_EQ(stats.pending, 5);
+
+    auto mutex = std::mutex{};
+    auto received = std::vector<flunder::variable_t>{};
+    auto subscriber = flunder::client_t{};
+    subscriber.connect("172.17.0.1", 7447);
+    res = subscriber.subscribe(
+        "flecs/flunder/test/outbox",
+        [&](flunder::client_t*, const flunder::variable_t* var) {
+            auto lock = std::lock_guard{mutex};
+            received.push_back(*var);
+        });
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+
+    /* replayed in order once connected, keeping the time they were published */
+    const auto connected = std::chrono::system_clock::now();
+    client.connect("172.17.0.1", 7447);
+    usleep(500000);
+    stats = client.outbox_stats();
+    ASSERT_EQ(stats.replayed, 5);
+    ASSERT_EQ(stats.pending, 0);
+    {
+        auto lock = std::lock_guard{mutex};
+        ASSERT_EQ(received.size(), 5);
+        for (auto i = 0; i < 5; ++i) {
+            ASSERT_EQ(received[i].value(), std::to_string(i));
+            const auto timestamp = std::stoll(std::string{received[i].timestamp()});
+            ASSERT_GE(timestamp, std::chrono::nanoseconds{before.time_since_epoch()}.count());
+            ASSERT_LT(timestamp, std::chrono::nanoseconds{connected.time_since_epoch()}.count());
+        }
+    }
+
+    /* once full, the oldest samples are discarded */
+    client.disconnect();
+    const auto payload = std::string(1024, 'x');
+    for (auto i = 0; i < 100; ++i) {
+        client.publish("flecs/flunder/test/outbox", payload);
+    }
+    stats = client.outbox_stats();
+    ASSERT_EQ(stats.buffered, 105);
+    ASSERT_GT(stats.discarded, 0);
+    ASSERT_EQ(stats.pending + stats.discarded, 100);
+
+    subscriber.unsubscribe("flecs/flunder/test/outbox");
+    res = client.disable_outbox();
+    ASSERT_EQ(res, 0);
+    std::filesystem::remove(path);
+}
+
+TEST(flunder, reconnect)
+{
+    auto client = flunder::client_t{};
+    client.connect("172.17.0.1", 7447);
+
+    auto received = std::atomic<int>{};
+    auto res = client.subscribe(
+        "flecs/flunder/test/reconnect",
+        [&](flunder::client_t*, const flunder::variable_t*) { ++received; });
+    ASSERT_EQ(res, 0);
+
+    /* subscriptions survive a reconnect */
+    res = client.reconnect();
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    client.publish("flecs/flunder/test/reconnect", "value");
+    usleep(100000);
+    ASSERT_EQ(received, 1);
+
+    client.unsubscribe("flecs/flunder/test/reconnect");
+}
+
+/* starts a router listening on endpoint, returns its pid or -1 */
+static auto start_router(const char* endpoint) //
+    -> pid_t
+{
+    auto pid = pid_t{};
+    char* argv[] = {
+        const_cast<char*>("zenohd"),
+        const_cast<char*>("--no-multicast-scouting"),
+        const_cast<char*>("-l"),
+        const_cast<char*>(endpoint),
+        nullptr};
+    if (posix_spawnp(&pid, "zenohd", nullptr, nullptr, argv, environ) != 0) {
+        return -1;
+    }
+    return pid;
+}
+
+static auto stop_router(pid_t pid) //
+    -> void
+{
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+TEST(flunder, reconnect_failover)
+{
+    if (std::system("command -v zenohd > /dev/null") != 0) {
+        GTEST_SKIP() << "zenohd not found";
+    }
+
+    constexpr auto endpoint = "tcp/127.0.0.1:7450";
+    auto router = start_router(endpoint);
+    ASSERT_NE(router, -1);
+    usleep(500000);
+
+    auto options = flunder::connect_options_t{};
+    /* the first endpoint is never reachable */
+    options.endpoints = {"tcp/127.0.0.1:7449", endpoint};
+    options.reconnect_delay_min = std::chrono::milliseconds{50};
+    options.reconnect_delay_max = std::chrono::milliseconds{500};
+    options.health_interval = std::chrono::milliseconds{50};
+
+    auto subscriber = flunder::client_t{};
+    auto res = subscriber.connect(options);
+    ASSERT_EQ(res, 0);
+    auto publisher = flunder::client_t{};
+    res = publisher.connect(options);
+    ASSERT_EQ(res, 0);
+
+    auto received = std::atomic<int>{};
+    res = subscriber.subscribe(
+        "flecs/flunder/test/failover",
+        [&](flunder::client_t*, const flunder::variable_t*) { ++received; });
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    publisher.publish("flecs/flunder/test/failover", "before");
+    usleep(100000);
+    ASSERT_EQ(received, 1);
+
+    /* kill the router and measure the time until samples flow again after its restart */
+    stop_router(router);
+    usleep(500000);
+    router = start_router(endpoint);
+    ASSERT_NE(router, -1);
+    const auto restarted = std::chrono::steady_clock::now();
+    auto recovered = false;
+    while (!recovered && std::chrono::steady_clock::now() - restarted < std::chrono::seconds{10}) {
+        publisher.publish("flecs/flunder/test/failover", "after");
+        usleep(10000);
+        recovered = received > 1;
+    }
+    const auto time_to_recover = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - restarted);
+    RecordProperty("time_to_recover_ms", static_cast<int>(time_to_recover.count()));
+    ASSERT_TRUE(recovered);
+
+    subscriber.disconnect();
+    publisher.disconnect();
+    stop_router(router);
+}
+
+TEST(flunder, failed_reconnect)
+{
+    if (std::system("command -v zenohd > /dev/null") != 0) {
+        GTEST_SKIP() << "zenohd not found";
+    }
+
+    constexpr auto endpoint = "tcp/127.0.0.1:7450";
+    const auto router = start_router(endpoint);
+    ASSERT_NE(router, -1);
+    usleep(500000);
+
+    auto client = flunder::client_t{};
+    auto res = client.connect("127.0.0.1", 7450);
+    ASSERT_EQ(res, 0);
+    res = client.add_mem_storage("flunder-test-failed-reconnect", "flecs/flunder/test/failed/**");
+    ASSERT_EQ(res, 0);
+
+    /* without a router, reconnecting fails and leaves the client without a session */
+    stop_router(router);
+    res = client.reconnect();
+    ASSERT_EQ(res, -1);
+    ASSERT_FALSE(client.is_connected());
+    ASSERT_EQ(client.erase("flecs/flunder/test/failed/value"), -1);
+    ASSERT_EQ(client.remove_mem_storage("flunder-test-failed-reconnect"), -1);
+    res = client.disconnect();
+    ASSERT_EQ(res, 0);
+}
+
+TEST(flunder, connect_async)
+{
+    if (std::system("command -v zenohd > /dev/null") != 0) {
+        GTEST_SKIP() << "zenohd not found";
+    }
+
+    constexpr auto endpoint = "tcp/127.0.0.1:7451";
+    auto options = flunder::connect_options_t{};
+    options.endpoints = {endpoint};
+    options.reconnect_delay_min = std::chrono::milliseconds{20};
+    options.reconnect_delay_max = std::chrono::milliseconds{20};
+
+    /* nothing is listening yet, so connecting must neither block nor fail */
+    auto subscriber = flunder::client_t{};
+    auto states = std::vector<flunder::connection_state_t>{};
+    subscriber.on_state_change([&](flunder::connection_state_t state) { states.push_back(state); });
+    auto subscriber_connected = subscriber.connect_async(options);
+    ASSERT_EQ(subscriber.state(), flunder::connection_state_t::connecting);
+    ASSERT_FALSE(subscriber.is_connected());
+
+    auto received = std::vector<std::string>{};
+    auto res = subscriber.subscribe(
+        "flecs/flunder/test/connect_async",
+        [&](flunder::client_t*, const flunder::variable_t* var) {
+            received.emplace_back(var->value());
+        });
+    ASSERT_EQ(res, 0);
+
+    /* retry late, so the subscriber is declared when the queued sample is published */
+    options.reconnect_delay_min = std::chrono::seconds{1};
+    options.reconnect_delay_max = std::chrono::seconds{1};
+    options.max_queued_publishes = 1;
+    auto publisher = flunder::client_t{};
+    auto publisher_cbk = std::promise<int>{};
+    auto publisher_connected =
+        publisher.connect_async(options, [&](int res) { publisher_cbk.set_value(res); });
+    res = publisher.publish("flecs/flunder/test/connect_async", "queued");
+    ASSERT_EQ(res, 0);
+    res = publisher.publish("flecs/flunder/test/connect_async", "overflow");
+    ASSERT_EQ(res, -1);
+
+    const auto router = start_router(endpoint);
+    ASSERT_NE(router, -1);
+    ASSERT_EQ(subscriber_connected.wait_for(std::chrono::seconds{5}), std::future_status::ready);
+    ASSERT_EQ(subscriber_connected.get(), 0);
+    ASSERT_EQ(publisher_connected.wait_for(std::chrono::seconds{5}), std::future_status::ready);
+    ASSERT_EQ(publisher_connected.get(), 0);
+    ASSERT_EQ(publisher_cbk.get_future().get(), 0);
+    ASSERT_TRUE(subscriber.is_connected());
+    usleep(100000);
+
+    ASSERT_EQ(received, std::vector<std::string>{"queued"});
+    ASSERT_EQ(
+        states,
+        (std::vector{
+            flunder::connection_state_t::connecting,
+            flunder::connection_state_t::connected}));
+
+    subscriber.disconnect();
+    publisher.disconnect();
+    ASSERT_EQ(subscriber.state(), flunder::connection_state_t::disconnected);
+    stop_router(router);
+
+    /* disconnecting cancels a pending connect */
+    auto cancelled = flunder::client_t{};
+    auto cancelled_connected = cancelled.connect_async(options);
+    cancelled.disconnect();
+    ASSERT_EQ(cancelled_connected.get(), -ECANCELED);
+}
+
+TEST(flunder, peer_unixsock)
+{
+    constexpr auto endpoint = "unixsock-stream//tmp/flunder-test-peer.sock";
+
+    /* two peers linked directly, without any router */
+    auto listener = flunder::client_t{};
+    auto options = flunder::connect_options_t{};
+    options.mode = flunder::session_mode_t::peer;
+    options.listen = {endpoint};
+    auto res = listener.connect(options);
+    ASSERT_EQ(res, 0);
+
+    auto connector = flunder::client_t{};
+    const char* endpoints[] = {endpoint};
+    auto c_options = flunder::flunder_connect_options_t{};
+    c_options.endpoints = endpoints;
+    c_options.endpoints_len = 1;
+    c_options.mode = flunder::FLUNDER_MODE_PEER;
+    res = flunder::flunder_connect_options(&connector, &c_options);
+    ASSERT_EQ(res, 0);
+
+    auto received = std::atomic<int>{};
+    res = listener.subscribe(
+        "flecs/flunder/test/peer",
+        [&](flunder::client_t*, const flunder::variable_t*) { ++received; });
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+    connector.publish("flecs/flunder/test/peer", "value");
+    usleep(100000);
+    ASSERT_EQ(received, 1);
+
+    connector.disconnect();
+    listener.disconnect();
+    std::filesystem::remove("/tmp/flunder-test-peer.sock");
+}
+
+TEST(flunder, transport_profile)
+{
+    auto options = flunder::connect_options_t{};
+    options.endpoints = {"tcp/172.17.0.1:7447"};
+    for (const auto profile :
+         {flunder::transport_profile_t::low_latency,
+          flunder::transport_profile_t::high_throughput,
+          flunder::transport_profile_t::constrained_memory}) {
+        auto client = flunder::client_t{};
+        options.profile = profile;
+        ASSERT_EQ(client.connect(options), 0);
+        ASSERT_EQ(client.publish("flecs/flunder/test/profile", "value"), 0);
+    }
+
+    /* overrides are applied on top of the profile */
+    auto client = flunder::client_t{};
+    options.config = {{"transport/link/tx/lease", "2000"}};
+    ASSERT_EQ(client.connect(options), 0);
+    client.disconnect();
+    options.config = {{"transport/link/tx/lease", "not a number"}};
+    ASSERT_EQ(client.connect(options), -1);
+    /* a rejected config is not retried in the background */
+    auto connected = client.connect_async(options);
+    ASSERT_EQ(connected.wait_for(std::chrono::seconds{1}), std::future_status::ready);
+    ASSERT_EQ(connected.get(), -EINVAL);
+    ASSERT_EQ(client.state(), flunder::connection_state_t::disconnected);
+}
+
+TEST(flunder, shared_session)
+{
+    auto options = flunder::connect_options_t{};
+    options.endpoints = {"tcp/172.17.0.1:7447"};
+    options.shared_session = true;
+
+    auto subscriber = flunder::client_t{};
+    auto publisher = flunder::client_t{};
+    ASSERT_EQ(subscriber.connect(options), 0);
+    ASSERT_EQ(publisher.connect(options), 0);
+
+    /* subscriptions stay with the client that made them */
+    auto received = std::atomic<int>{};
+    auto res = subscriber.subscribe(
+        "flecs/flunder/test/shared",
+        [&](flunder::client_t*, const flunder::variable_t*) { ++received; });
+    ASSERT_EQ(res, 0);
+    ASSERT_EQ(publisher.unsubscribe("flecs/flunder/test/shared"), -1);
+    usleep(100000);
+    publisher.publish("flecs/flunder/test/shared", "value");
+    usleep(100000);
+    ASSERT_EQ(received, 1);
+
+    {
+        /* further clients add neither a session nor a monitor thread */
+        const auto threads = std::distance(
+            std::filesystem::directory_iterator{"/proc/self/task"},
+            std::filesystem::directory_iterator{});
+        auto clients = std::vector<flunder::client_t>(4);
+        for (auto& client : clients) {
+            ASSERT_EQ(client.connect(options), 0);
+        }
+        ASSERT_EQ(
+            std::distance(
+                std::filesystem::directory_iterator{"/proc/self/task"},
+                std::filesystem::directory_iterator{}),
+            threads);
+    }
+
+    /* the session remains open for the other client */
+    subscriber.disconnect();
+    ASSERT_TRUE(publisher.is_connected());
+    ASSERT_EQ(publisher.publish("flecs/flunder/test/shared", "value"), 0);
+    usleep(100000);
+    ASSERT_EQ(received, 1);
+
+    publisher.disconnect();
+}
+
+TEST(flunder, shards)
+{
+    auto options = flunder::connect_options_t{};
+    options.endpoints = {"tcp/172.17.0.1:7447"};
+    options.shards = 4;
+
+    auto subscriber = flunder::client_t{};
+    ASSERT_EQ(subscriber.connect("172.17.0.1", 7447), 0);
+    auto publisher = flunder::client_t{};
+    ASSERT_EQ(publisher.connect(options), 0);
+
+    constexpr auto topics = 8;
+    constexpr auto samples = 100;
+    auto mutex = std::mutex{};
+    auto received = std::map<std::string, std::vector<int>>{};
+    auto res = subscriber.subscribe(
+        "flecs/flunder/test/shards/*",
+        [&](flunder::client_t*, const flunder::variable_t* var) {
+            auto lock = std::lock_guard{mutex};
+            received[std::string{var->topic()}].push_back(std::stoi(std::string{var->value()}));
+        });
+    ASSERT_EQ(res, 0);
+    usleep(100000);
+
+    /* topics are spread over the shards, each keeping its samples in order */
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < topics; ++t) {
+        threads.emplace_back([&publisher, t]() {
+            const auto topic = "flecs/flunder/test/shards/" + std::to_string(t);
+            for (auto i = 0; i < samples; ++i) {
+                publisher.publish(topic, std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    usleep(500000);
+
+    auto lock = std::lock_guard{mutex};
+    ASSERT_EQ(received.size(), static_cast<std::size_t>(topics));
+    for (const auto& [topic, values] : received) {
+        ASSERT_EQ(values.size(), static_cast<std::size_t>(samples));
+        ASSERT_TRUE(std::is_sorted(values.cbegin(), values.cend())) << topic;
+    }
+}